@@ -0,0 +1,264 @@
+#include <functional>
+#include <random>
+
+#include "synthesis.hpp"
+#include "harness.hpp"
+#include "../tests/test_utils.hpp"
+
+// usage: benchmarks_primitives [--filter SUBSTRING] [--min-dim N] [--max-dim N] [--min-time SECONDS] [--repetitions N]
+//                              [--seed N] [--output FILE] [--baseline FILE] [--tolerance X]
+// an entry is named KERNEL/DIM, its seconds are the time of one call
+
+static const size_t MIN_DIM = 3;
+static const size_t MAX_DIM = 16;
+static const size_t SPECTRUM_MAX_DIM = 12;
+static const size_t GATES_MAX_DIM = 10;
+
+// a kernel prepares its data for the dimension and returns the timed call
+using kernel_type = std::function<std::function<void()>(size_t, std::mt19937_64 &)>;
+
+struct Kernel {
+    std::string name;
+    // the kernels slower than linear in the table size are limited: the spectrum is computed in 4^dim operations,
+    // the number of kCNOT gates grows as 3^dim
+    size_t max_dim;
+    kernel_type prepare;
+};
+
+// keeps the result alive, so the call is not optimized out
+template<typename T>
+void consume(const T &value) {
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+static BooleanFunction random_function(size_t dim, std::mt19937_64 &generator) {
+    binary_vector values(size_t(1) << dim);
+    std::bernoulli_distribution bit;
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = bit(generator);
+    }
+    return BooleanFunction(values);
+}
+
+static cf_set identity_functions(size_t dim) {
+    cf_set functions;
+    for (size_t i = 0; i < dim; i++) {
+        functions.emplace_back(i, dim);
+    }
+    return functions;
+}
+
+// a gate of the type on random lines, kCNOT takes half of the other lines as controls
+static Gate random_gate(GateType type, size_t dim, std::mt19937_64 &generator) {
+    std::vector<size_t> lines(dim);
+    std::iota(lines.begin(), lines.end(), 0);
+    std::shuffle(lines.begin(), lines.end(), generator);
+    std::bernoulli_distribution polarity;
+    switch (type) {
+        case GateType::NOT:
+            return Gate(type, {lines[0]}, {}, dim);
+        case GateType::CNOT:
+            return Gate(type, {lines[0]}, {{lines[1], polarity(generator)}}, dim);
+        case GateType::kCNOT: {
+            controls_type controls;
+            for (size_t i = 1; i <= std::max<size_t>(dim / 2, 1); i++) {
+                controls[lines[i]] = polarity(generator);
+            }
+            return Gate(type, {lines[0]}, controls, dim);
+        }
+        case GateType::SWAP:
+            return Gate(type, {lines[0], lines[1]}, {}, dim);
+        default:
+            return Gate(type, {lines[0], lines[1]}, {{lines[2], polarity(generator)}}, dim);
+    }
+}
+
+// 4 * dim random gates, the size the greedy algorithms produce for small widths
+static std::vector<Gate> random_gates(size_t dim, std::mt19937_64 &generator) {
+    std::uniform_int_distribution<int> type(0, 4);
+    std::vector<Gate> gates;
+    for (size_t i = 0; i < 4 * dim; i++) {
+        gates.push_back(random_gate(GateType(type(generator)), dim, generator));
+    }
+    return gates;
+}
+
+static Circuit random_circuit(size_t dim, std::mt19937_64 &generator) {
+    return Circuit(random_gates(dim, generator));
+}
+
+// every random gate repeated, the half of them cancels out in the reduction
+static Circuit redundant_circuit(size_t dim, std::mt19937_64 &generator) {
+    std::vector<Gate> doubled;
+    for (const auto &gate: random_gates(dim, generator)) {
+        doubled.push_back(gate);
+        doubled.push_back(gate);
+    }
+    return Circuit(doubled);
+}
+
+static kernel_type gate_act(GateType type) {
+    return [type](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+        auto gate = random_gate(type, dim, generator);
+        auto functions = identity_functions(dim);
+        return [gate, functions]() mutable {
+            gate.act(functions);
+            consume(functions);
+        };
+    };
+}
+
+static std::vector<Kernel> kernels() {
+    return {
+            {"bf_xor", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto f = random_function(dim, generator);
+                auto g = random_function(dim, generator);
+                return [f, g]() mutable {
+                    f += g;
+                    consume(f);
+                };
+            }},
+            {"bf_and", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto f = random_function(dim, generator);
+                auto g = random_function(dim, generator);
+                return [f, g]() mutable {
+                    f *= g;
+                    consume(f);
+                };
+            }},
+            {"bf_or", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto f = random_function(dim, generator);
+                auto g = random_function(dim, generator);
+                return [f, g]() mutable {
+                    f |= g;
+                    consume(f);
+                };
+            }},
+            {"bf_not", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto f = random_function(dim, generator);
+                return [f]() mutable {
+                    consume(~f);
+                };
+            }},
+            {"bf_rw_spectrum", SPECTRUM_MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto f = random_function(dim, generator);
+                return [f]() {
+                    consume(f.RW_spectrum());
+                };
+            }},
+            {"bf_complexity", SPECTRUM_MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto f = random_function(dim, generator);
+                return [f]() {
+                    consume(f.complexity());
+                };
+            }},
+            {"bf_mobius", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto f = random_function(dim, generator);
+                return [f]() {
+                    consume(f.mobius_transformation());
+                };
+            }},
+            {"sub_multiply", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto s1 = random_substitution(dim, generator);
+                auto s2 = random_substitution(dim, generator);
+                return [s1, s2]() mutable {
+                    s1 *= s2;
+                    consume(s1);
+                };
+            }},
+            {"sub_cycles", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto s = random_substitution(dim, generator);
+                return [s]() {
+                    consume(s.cycles());
+                };
+            }},
+            {"cayley_distance", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto s1 = random_substitution(dim, generator);
+                auto s2 = random_substitution(dim, generator);
+                return [s1, s2]() {
+                    consume(cayley_distance(s1, s2));
+                };
+            }},
+            {"gate_act_not", MAX_DIM, gate_act(GateType::NOT)},
+            {"gate_act_cnot", MAX_DIM, gate_act(GateType::CNOT)},
+            {"gate_act_kcnot", MAX_DIM, gate_act(GateType::kCNOT)},
+            {"gate_act_swap", MAX_DIM, gate_act(GateType::SWAP)},
+            {"gate_act_cswap", MAX_DIM, gate_act(GateType::CSWAP)},
+            {"circuit_produce_mapping", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto c = random_circuit(dim, generator);
+                return [c]() {
+                    consume(c.produce_mapping());
+                };
+            }},
+            // the circuit is copied on every call, the reduction changes it
+            {"circuit_reduce", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto c = redundant_circuit(dim, generator);
+                return [c]() {
+                    auto reduced = c;
+                    reduced.reduce();
+                    consume(reduced);
+                };
+            }},
+            {"generate_all_gates", GATES_MAX_DIM, [](size_t dim, std::mt19937_64 &) -> std::function<void()> {
+                return [dim]() {
+                    consume(generate_all_gates(dim));
+                };
+            }},
+            {"parse_substitution", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                std::stringstream ss;
+                ss << random_substitution(dim, generator);
+                return [s = ss.str()]() {
+                    consume(Substitution(s));
+                };
+            }},
+            {"parse_truth_table", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto s = "# tt\n" + BinaryMapping(random_substitution(dim, generator)).to_table();
+                return [s]() {
+                    consume(BinaryMapping(s));
+                };
+            }},
+            {"parse_circuit", MAX_DIM, [](size_t dim, std::mt19937_64 &generator) -> std::function<void()> {
+                auto s = std::string(random_circuit(dim, generator));
+                return [s]() {
+                    consume(Circuit(s));
+                };
+            }},
+    };
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        const auto options = parse_options(argc, argv);
+        const auto filter = option(options, "--filter", "");
+        const auto min_dim = std::stoul(option(options, "--min-dim", std::to_string(MIN_DIM)));
+        const auto max_dim = std::stoul(option(options, "--max-dim", std::to_string(MAX_DIM)));
+        const auto min_time = std::stod(option(options, "--min-time", "0.05"));
+        const auto repetitions = std::stoul(option(options, "--repetitions", "3"));
+        std::mt19937_64 generator(std::stoull(option(options, "--seed", "42")));
+
+        std::vector<BenchmarkEntry> entries;
+        for (const auto &kernel: kernels()) {
+            if (kernel.name.find(filter) == std::string::npos) {
+                continue;
+            }
+            for (size_t dim = min_dim; dim <= std::min(max_dim, kernel.max_dim); dim++) {
+                BenchmarkEntry entry{kernel.name + "/" + std::to_string(dim), 0, {}, ""};
+                try {
+                    auto call = kernel.prepare(dim, generator);
+                    size_t calls = 0;
+                    entry.seconds = measure_per_call(call, min_time, repetitions, calls);
+                    entry.metrics["calls"] = static_cast<double>(calls);
+                } catch (const std::exception &e) {
+                    entry.error = e.what();
+                }
+                std::cout << to_json(entry) << std::endl;
+                entries.push_back(entry);
+            }
+        }
+        // the calls take microseconds, so the time is compared by the tolerance only
+        return finish(options, entries, 0);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,73 @@
+#include "statistics.hpp"
+#include "harness.hpp"
+
+// usage: benchmarks_statistics [--algos dummy,rw,gs,zkb,ca,opt,auto,portfolio,beam,mitm] [--dim N] [--samples N]
+//                              [--seed N] [--jobs N] [--reduction] [--checkpoints DIR] [--output FILE]
+// up to EXHAUSTIVE_MAX_DIM lines every substitution is synthesized unless --samples is given, beyond that
+// DEFAULT_SAMPLES random substitutions are
+
+static const std::map<std::string, Algo> ALGORITHMS = {
+        {"dummy",     Algo::DUMMY},
+        {"rw",        Algo::RW},
+        {"gs",        Algo::GS},
+        {"zkb",       Algo::ZKB},
+        {"ca",        Algo::CA},
+        {"opt",       Algo::OPT},
+        {"auto",      Algo::AUTO},
+        {"portfolio", Algo::PORTFOLIO},
+        {"beam",      Algo::GS_BEAM},
+        {"mitm",      Algo::MITM},
+};
+
+static const size_t DEFAULT_SAMPLES = 1000;
+
+int main(int argc, char *argv[]) {
+    try {
+        const auto options = parse_options(argc, argv);
+        const auto dim = std::stoul(option(options, "--dim", "3"));
+        auto samples = std::stoul(option(options, "--samples", "0"));
+        if (!samples && dim > EXHAUSTIVE_MAX_DIM) {
+            samples = DEFAULT_SAMPLES;
+        }
+        const auto seed = std::stoull(option(options, "--seed", "42"));
+        const bool reduction = options.count("--reduction");
+        const auto checkpoints = option(options, "--checkpoints", "");
+        JobsConfig::instance().set(std::stoul(option(options, "--jobs", "1")));
+
+        std::stringstream ss;
+        ss << "{\n";
+        bool first = true;
+        for (const auto &algo_name: split(option(options, "--algos", "dummy,rw,gs,zkb,ca,opt"), ',')) {
+            auto algo = ALGORITHMS.find(algo_name);
+            if (algo == ALGORITHMS.end()) {
+                throw std::runtime_error("Unknown algorithm: " + algo_name);
+            }
+            auto name = algo_name + "/" + std::to_string(dim);
+            auto checkpoint = checkpoints.empty() ? "" : checkpoints + "/" + algo_name + "_" + std::to_string(dim) +
+                                                         ".txt";
+            auto statistics = samples ? sampled_statistics(algo->second, dim, samples, seed, reduction, checkpoint)
+                                      : exhaustive_statistics(algo->second, dim, reduction, checkpoint);
+            std::cerr << name << ": " << statistics.processed() << " substitutions, " << statistics.failed()
+                      << " failed, mean gates " << statistics.gates().mean() << std::endl;
+            auto json = statistics.to_json();
+            json.pop_back();
+            ss << (first ? "" : ",\n") << "\"" << name << "\": " << json;
+            first = false;
+        }
+        ss << "\n}\n";
+
+        if (auto output = option(options, "--output", ""); !output.empty()) {
+            std::ofstream file(output);
+            file << ss.str();
+            if (!file) {
+                throw std::runtime_error("Unable to write statistics: " + output);
+            }
+        } else {
+            std::cout << ss.str();
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
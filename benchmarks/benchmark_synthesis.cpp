@@ -0,0 +1,184 @@
+#include <filesystem>
+#include <random>
+
+#include "autotune.hpp"
+#include "database.hpp"
+#include "harness.hpp"
+#include "mitm.hpp"
+#include "../tests/test_utils.hpp"
+
+// usage: benchmarks_synthesis [--data DIR] [--algos dummy,rw,gs,zkb,ca,opt,auto,portfolio,beam,mitm]
+//                             [--min-width N] [--max-width N] [--random N] [--seed N] [--repetitions N] [--jobs N]
+//                             [--max-lines N] [--reduction] [--output FILE] [--baseline FILE] [--tolerance X]
+//                             [--cost-model FILE]
+// --cost-model fits the model of Algo::AUTO by the runs of its candidates and saves it
+
+static const std::map<std::string, Algo> ALGORITHMS = {
+        {"dummy",     Algo::DUMMY},
+        {"rw",        Algo::RW},
+        {"gs",        Algo::GS},
+        {"zkb",       Algo::ZKB},
+        {"ca",        Algo::CA},
+        {"opt",       Algo::OPT},
+        {"auto",      Algo::AUTO},
+        {"portfolio", Algo::PORTFOLIO},
+        {"beam",      Algo::GS_BEAM},
+        {"mitm",      Algo::MITM},
+};
+
+// the widest circuit an algorithm is run for by default, the greedy ones are too slow beyond
+static const std::map<std::string, size_t> MAX_LINES = {
+        {"dummy",     16},
+        {"rw",        6},
+        {"gs",        6},
+        {"zkb",       16},
+        {"ca",        7},
+        {"opt",       OPT_MAX_DIM},
+        {"auto",      16},
+        {"portfolio", 6},
+        {"beam",      5},
+        {"mitm",      MITM_MAX_DIM},
+};
+
+struct BenchmarkInput {
+    std::string name;
+    std::string content;
+    bool is_table;
+    size_t inputs;
+    size_t outputs;
+    bool is_reversible;
+
+    // the dummy algorithm always adds a line for every output, the others extend irreversible mappings only
+    [[nodiscard]] size_t lines(Algo algo) const {
+        return algo == Algo::DUMMY || !is_reversible ? inputs + outputs : inputs;
+    }
+};
+
+// files of tests/benchmarks start with '# sub' or '# tt'
+static std::vector<BenchmarkInput> read_inputs(const std::string &directory) {
+    std::vector<BenchmarkInput> inputs;
+    for (const auto &file: std::filesystem::directory_iterator(directory)) {
+        if (file.path().extension() != ".txt") {
+            continue;
+        }
+        std::ifstream stream(file.path());
+        std::stringstream ss;
+        ss << stream.rdbuf();
+        BenchmarkInput input{file.path().stem().string(), ss.str(), false, 0, 0, true};
+
+        std::string type_line;
+        std::getline(ss.seekg(0), type_line);
+        input.is_table = type_line.find("tt") != std::string::npos;
+        if (input.is_table) {
+            BinaryMapping bm(input.content);
+            input.inputs = bm.inputs_number();
+            input.outputs = bm.outputs_number();
+            input.is_reversible = bm.is_substitution();
+        } else {
+            input.inputs = static_cast<size_t>(std::log2(Substitution(input.content).power()));
+            input.outputs = input.inputs;
+        }
+        inputs.push_back(input);
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const auto &i1, const auto &i2) {
+        return i1.name < i2.name;
+    });
+    return inputs;
+}
+
+static std::vector<BenchmarkInput> random_inputs(size_t min_width, size_t max_width, size_t number, uint64_t seed) {
+    std::mt19937_64 generator(seed);
+    std::vector<BenchmarkInput> inputs;
+    for (size_t width = min_width; width <= max_width; width++) {
+        for (size_t i = 0; i < number; i++) {
+            std::stringstream ss;
+            ss << random_substitution(width, generator);
+            inputs.push_back({"random_" + std::to_string(width) + "_" + std::to_string(i), ss.str(), false, width, width,
+                              true});
+        }
+    }
+    return inputs;
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        const auto options = parse_options(argc, argv);
+        const auto repetitions = std::stoul(option(options, "--repetitions", "3"));
+        const bool reduction = options.count("--reduction");
+        JobsConfig::instance().set(std::stoul(option(options, "--jobs", "1")));
+
+        auto inputs = read_inputs(option(options, "--data", "tests/benchmarks"));
+        auto random = random_inputs(std::stoul(option(options, "--min-width", "3")),
+                                    std::stoul(option(options, "--max-width", "8")),
+                                    std::stoul(option(options, "--random", "3")),
+                                    std::stoull(option(options, "--seed", "42")));
+        inputs.insert(inputs.end(), random.begin(), random.end());
+
+        std::vector<BenchmarkEntry> entries;
+        std::vector<CostSample> samples;
+        for (const auto &algo_name: split(option(options, "--algos", "dummy,rw,gs,zkb,ca,opt,auto"), ',')) {
+            auto algo = ALGORITHMS.find(algo_name);
+            if (algo == ALGORITHMS.end()) {
+                throw std::runtime_error("Unknown algorithm: " + algo_name);
+            }
+            const size_t max_lines = std::stoul(option(options, "--max-lines", std::to_string(MAX_LINES.at(algo_name))));
+            if (algo->second == Algo::OPT) {
+                // the database is built lazily, its construction must not be timed as the first synthesis
+                for (size_t dim = 1; dim <= std::min(max_lines, OPT_MAX_DIM); dim++) {
+                    OptimalDatabase::instance().build(dim);
+                }
+            }
+            for (const auto &input: inputs) {
+                if (input.lines(algo->second) > max_lines) {
+                    continue;
+                }
+                auto entry = run_isolated(algo_name + "/" + input.name, [&]() {
+                    BenchmarkEntry result;
+                    auto start = std::chrono::steady_clock::now();
+                    try {
+                        Circuit c(1);
+                        if (input.is_table) {
+                            BinaryMapping bm(input.content);
+                            result.seconds = measure([&]() {
+                                c = synthesize(bm, algo->second, reduction);
+                            }, repetitions);
+                        } else {
+                            Substitution sub(input.content);
+                            result.seconds = measure([&]() {
+                                c = synthesize(sub, algo->second, reduction);
+                            }, repetitions);
+                        }
+                        result.metrics["lines"] = static_cast<double>(c.dim());
+                        result.metrics["gates"] = static_cast<double>(c.complexity());
+                        result.metrics["memory"] = static_cast<double>(c.memory());
+                    } catch (const std::exception &e) {
+                        // a failed synthesis is not compared by time, the time only shows where the run went
+                        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                        result.error = e.what();
+                    }
+                    return result;
+                });
+                std::cout << to_json(entry) << std::endl;
+                entries.push_back(entry);
+                if (std::find(AUTO_CANDIDATES.begin(), AUTO_CANDIDATES.end(), algo->second) != AUTO_CANDIDATES.end()) {
+                    auto features = input.is_table ? synthesis_features(BinaryMapping(input.content))
+                                                   : synthesis_features(Substitution(input.content));
+                    auto gates = entry.metrics.find("gates");
+                    samples.push_back({algo->second, features, entry.seconds,
+                                       gates == entry.metrics.end() ? 0 : static_cast<size_t>(gates->second),
+                                       !entry.error.empty()});
+                }
+            }
+        }
+        if (auto path = option(options, "--cost-model", ""); !path.empty()) {
+            for (const auto &[algo, coefficients]: CostModel::fit(samples)) {
+                CostModel::instance().set(algo, coefficients);
+            }
+            CostModel::instance().save(path);
+        }
+        return finish(options, entries);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,313 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_HARNESS_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_HARNESS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// one measured case; a result file is a JSON array with one entry per line, so baselines are read back line by line
+struct BenchmarkEntry {
+    std::string name;
+    double seconds = 0;
+    std::map<std::string, double> metrics;
+    std::string error;
+};
+
+using benchmark_options = std::map<std::string, std::string>;
+
+// metrics which must not grow against the baseline, the time is compared with a tolerance (0.5 by default, the
+// memory-bound cases vary that much between runs on a loaded machine)
+static const std::vector<std::string> EXACT_METRICS = {"gates", "memory"};
+
+// a slower run is a regression only above this absolute difference, shorter runs are mostly noise
+static const double MIN_SECONDS_DIFFERENCE = 5e-3;
+
+inline long peak_rss_kb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// the time of one call: the calls are batched until a batch takes min_seconds, the best of the batches is taken
+template<typename Function>
+double measure_per_call(Function function, double min_seconds, size_t repetitions, size_t &calls) {
+    auto batch = [&function](size_t n) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            function();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    double seconds = 0;
+    for (calls = 1; (seconds = batch(calls)) < min_seconds; calls *= 2);
+    for (size_t i = 1; i < repetitions; i++) {
+        seconds = std::min(seconds, batch(calls));
+    }
+    return seconds / static_cast<double>(calls);
+}
+
+// the best of the repetitions, the minimum is the least disturbed by other processes
+template<typename Function>
+double measure(Function function, size_t repetitions) {
+    double best = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < std::max<size_t>(repetitions, 1); i++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+inline std::string escape_json(const std::string &s) {
+    std::string out;
+    for (char c: s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+inline std::string to_json(const BenchmarkEntry &entry) {
+    std::stringstream ss;
+    ss.precision(9);
+    ss << "{\"name\": \"" << escape_json(entry.name) << "\", \"seconds\": " << entry.seconds;
+    for (const auto &[metric, value]: entry.metrics) {
+        ss << ", \"" << escape_json(metric) << "\": " << value;
+    }
+    if (!entry.error.empty()) {
+        ss << ", \"error\": \"" << escape_json(entry.error) << '"';
+    }
+    ss << '}';
+    return ss.str();
+}
+
+inline void write_entries(const std::string &path, const std::vector<BenchmarkEntry> &entries) {
+    std::ofstream file(path);
+    file << "[\n";
+    for (size_t i = 0; i < entries.size(); i++) {
+        file << "  " << to_json(entries[i]) << (i + 1 < entries.size() ? ",\n" : "\n");
+    }
+    file << "]\n";
+    if (!file) {
+        throw std::runtime_error("Unable to write benchmark results: " + path);
+    }
+}
+
+// parses one line written by to_json
+inline BenchmarkEntry parse_entry(const std::string &line) {
+    auto begin = line.find('{');
+    auto end = line.rfind('}');
+    BenchmarkEntry entry;
+    if (begin == std::string::npos || end == std::string::npos) {
+        return entry;
+    }
+    size_t pos = begin + 1;
+    while (pos < end) {
+        auto key_begin = line.find('"', pos);
+        if (key_begin == std::string::npos || key_begin >= end) {
+            break;
+        }
+        auto key_end = line.find('"', key_begin + 1);
+        auto key = line.substr(key_begin + 1, key_end - key_begin - 1);
+        auto value_begin = line.find_first_not_of(" :", key_end + 1);
+        std::string value;
+        if (line[value_begin] == '"') {
+            size_t value_end = value_begin + 1;
+            for (; value_end < end && line[value_end] != '"'; value_end++) {
+                if (line[value_end] == '\\') {
+                    value_end++;
+                }
+                value += line[value_end];
+            }
+            pos = value_end + 1;
+        } else {
+            auto value_end = std::min(line.find(',', value_begin), end);
+            value = line.substr(value_begin, value_end - value_begin);
+            pos = value_end;
+        }
+        if (key == "name") {
+            entry.name = value;
+        } else if (key == "error") {
+            entry.error = value;
+        } else if (key == "seconds") {
+            entry.seconds = std::stod(value);
+        } else {
+            entry.metrics[key] = std::stod(value);
+        }
+    }
+    return entry;
+}
+
+// reads only the files written by write_entries
+inline std::vector<BenchmarkEntry> read_entries(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Unable to read benchmark baseline: " + path);
+    }
+    std::vector<BenchmarkEntry> entries;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find('{') != std::string::npos) {
+            entries.push_back(parse_entry(line));
+        }
+    }
+    return entries;
+}
+
+// runs a case in a child process, so neither the heap left by the previous cases nor their peak RSS affect it
+template<typename Case>
+BenchmarkEntry run_isolated(const std::string &name, Case run_case) {
+    int fds[2];
+    if (pipe(fds)) {
+        throw std::runtime_error("Unable to create a pipe for " + name);
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw std::runtime_error("Unable to fork for " + name);
+    }
+    if (!pid) {
+        close(fds[0]);
+        BenchmarkEntry entry = run_case();
+        entry.name = name;
+        entry.metrics["peak_rss_kb"] = static_cast<double>(peak_rss_kb());
+        auto json = to_json(entry) + "\n";
+        for (size_t written = 0; written < json.size();) {
+            auto n = write(fds[1], json.data() + written, json.size() - written);
+            if (n <= 0) {
+                break;
+            }
+            written += n;
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string json;
+    char buffer[4096];
+    for (ssize_t n; (n = read(fds[0], buffer, sizeof(buffer))) > 0;) {
+        json.append(buffer, n);
+    }
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (json.empty()) {
+        BenchmarkEntry entry{name, 0, {}, "the case process has crashed"};
+        if (WIFSIGNALED(status)) {
+            entry.error += " with signal " + std::to_string(WTERMSIG(status));
+        }
+        return entry;
+    }
+    return parse_entry(json);
+}
+
+// prints every regression against the baseline, returns their number
+inline size_t compare_entries(const std::vector<BenchmarkEntry> &baseline, const std::vector<BenchmarkEntry> &entries,
+                              double tolerance, double min_difference = MIN_SECONDS_DIFFERENCE) {
+    std::map<std::string, const BenchmarkEntry *> current;
+    for (const auto &entry: entries) {
+        current[entry.name] = &entry;
+    }
+    size_t regressions = 0;
+    auto report = [&regressions](const std::string &name, const std::string &message) {
+        std::cerr << "REGRESSION " << name << ": " << message << std::endl;
+        regressions++;
+    };
+    for (const auto &base: baseline) {
+        auto it = current.find(base.name);
+        if (it == current.end()) {
+            continue;
+        }
+        const auto &entry = *it->second;
+        if (!entry.error.empty()) {
+            if (base.error.empty()) {
+                report(base.name, "fails with '" + entry.error + "'");
+            }
+            continue;
+        }
+        if (entry.seconds > base.seconds * (1 + tolerance) && entry.seconds - base.seconds > min_difference) {
+            std::stringstream ss;
+            ss.precision(3);
+            ss << "time " << base.seconds << " s -> " << entry.seconds << " s";
+            report(base.name, ss.str());
+        }
+        for (const auto &metric: EXACT_METRICS) {
+            auto base_metric = base.metrics.find(metric);
+            auto entry_metric = entry.metrics.find(metric);
+            if (base_metric != base.metrics.end() && entry_metric != entry.metrics.end() &&
+                entry_metric->second > base_metric->second) {
+                report(base.name, metric + " " + std::to_string(base_metric->second) + " -> " +
+                                  std::to_string(entry_metric->second));
+            }
+        }
+    }
+    return regressions;
+}
+
+// --key value pairs, a key without a value is stored empty
+inline benchmark_options parse_options(int argc, char *argv[]) {
+    benchmark_options options;
+    for (int i = 1; i < argc; i++) {
+        std::string key = argv[i];
+        if (key.rfind("--", 0) != 0) {
+            throw std::runtime_error("Unknown argument: " + key);
+        }
+        if (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0) {
+            options[key] = argv[++i];
+        } else {
+            options[key] = "";
+        }
+    }
+    return options;
+}
+
+inline std::string option(const benchmark_options &options, const std::string &key, const std::string &value) {
+    auto it = options.find(key);
+    return it == options.end() ? value : it->second;
+}
+
+inline std::vector<std::string> split(const std::string &s, char sep) {
+    std::vector<std::string> parts;
+    std::stringstream ss(s);
+    std::string part;
+    while (std::getline(ss, part, sep)) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+// writes the results and compares them with the baseline if the options ask, returns the exit code
+inline int finish(const benchmark_options &options, const std::vector<BenchmarkEntry> &entries,
+                  double min_difference = MIN_SECONDS_DIFFERENCE) {
+    if (auto it = options.find("--output"); it != options.end()) {
+        write_entries(it->second, entries);
+    }
+    auto it = options.find("--baseline");
+    if (it == options.end()) {
+        return 0;
+    }
+    double tolerance = 0.5;
+    if (auto tolerance_it = options.find("--tolerance"); tolerance_it != options.end()) {
+        tolerance = std::stod(tolerance_it->second);
+    }
+    auto regressions = compare_entries(read_entries(it->second), entries, tolerance, min_difference);
+    std::cout << regressions << " regressions against " << it->second << std::endl;
+    return regressions ? 1 : 0;
+}
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_HARNESS_HPP
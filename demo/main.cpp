@@ -35,15 +35,27 @@ void print_program_help() {
     std::cout << std::endl;
 
     std::cout << "Synthesis options:" << std::endl;
-    std::cout << "  -a, --algo ARG      algorithm to synthesis quantum circuit ('dummy', 'rw', 'gs', 'zkb', 'ca')"
+    std::cout << "  -a, --algo ARG      algorithm to synthesis quantum circuit ('dummy', 'rw', 'gs', 'zkb', 'ca', "
+                 "'opt', 'auto', 'portfolio', 'beam', 'mitm')"
               << std::endl;
     std::cout << "  -r, --reduction     reduce the output circuit (default: false)" << std::endl;
     std::cout << "  -j, --jobs ARG      maximum number of jobs running in parallel (default: 1)" << std::endl;
+    std::cout << "  -w, --beam-width ARG  number of partial circuits kept by 'beam' algorithm (default: 8)"
+              << std::endl;
+    std::cout << "  -T, --time-limit ARG  maximum time of the synthesis in milliseconds (default: no limit)"
+              << std::endl;
+    std::cout << "  -v, --verify ARG    verification of the synthesized circuit ('none', 'sampled' - on random rows, "
+                 "'full') (default: 'full')" << std::endl;
+    std::cout << "  -d, --database ARG  path to the database of optimal circuits for 'opt' algorithm "
+                 "(built and saved if the file does not exist)" << std::endl;
+    std::cout << "  -m, --cost-model ARG  path to the cost model of 'auto' algorithm (default: the built-in one)"
+              << std::endl;
     std::cout << std::endl;
 
     std::cout << "Parameters:" << std::endl;
     std::cout << "  -i, --input ARG     path to input file" << std::endl;
     std::cout << "  -o, --output ARG    path to output file (default: prints into standard output)" << std::endl;
+    std::cout << "  -p, --profile ARG   path to JSON file with the time spent in every phase" << std::endl;
     std::cout << std::endl;
 }
 
@@ -63,10 +75,22 @@ configuration parse_arguments(int argc, char *argv[]) {
             {"--reduction", "--reduction"},
             {"-j",          "--jobs"},
             {"--jobs",      "--jobs"},
+            {"-w",          "--beam-width"},
+            {"--beam-width", "--beam-width"},
+            {"-T",          "--time-limit"},
+            {"--time-limit", "--time-limit"},
+            {"-v",          "--verify"},
+            {"--verify",    "--verify"},
+            {"-d",          "--database"},
+            {"--database",  "--database"},
+            {"-m",          "--cost-model"},
+            {"--cost-model", "--cost-model"},
             {"-i",          "--input"},
             {"--input",     "--input"},
             {"-o",          "--output"},
             {"--output",    "--output"},
+            {"-p",          "--profile"},
+            {"--profile",   "--profile"},
     };
     std::map<std::string, bool> arguments_accounting = {
             {"--version",   false},
@@ -76,8 +100,14 @@ configuration parse_arguments(int argc, char *argv[]) {
             {"--algo",      false},
             {"--reduction", false},
             {"--jobs",      false},
+            {"--beam-width", false},
+            {"--time-limit", false},
+            {"--verify",    false},
+            {"--database",  false},
+            {"--cost-model", false},
             {"--input",     false},
             {"--output",    false},
+            {"--profile",   false},
     };
 
     configuration config;
@@ -186,6 +216,16 @@ int main(int argc, char *argv[]) {
         algo = Algo::ZKB;
     } else if (algo_s == "ca") {
         algo = Algo::CA;
+    } else if (algo_s == "opt") {
+        algo = Algo::OPT;
+    } else if (algo_s == "auto") {
+        algo = Algo::AUTO;
+    } else if (algo_s == "portfolio") {
+        algo = Algo::PORTFOLIO;
+    } else if (algo_s == "beam") {
+        algo = Algo::GS_BEAM;
+    } else if (algo_s == "mitm") {
+        algo = Algo::MITM;
     } else if (!algo_s.empty()) {
         algo = Algo::UNKNOWN;
     }
@@ -244,12 +284,102 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    it = config.find("--beam-width");
+    if (it != config.end()) {
+        size_t beam_width = 0;
+        try {
+            // stoul would wrap a negative width around
+            auto width = std::stoll(it->second);
+            if (width < 1) {
+                throw std::out_of_range("beam width");
+            }
+            beam_width = static_cast<size_t>(width);
+        } catch (...) {
+            LOG_ERROR("Processing parameters", "Beam width should be integer gather than 1");
+            return 1;
+        }
+        BeamConfig::instance().set(beam_width);
+    }
+
+    it = config.find("--time-limit");
+    std::chrono::milliseconds time_limit(0);
+    if (it != config.end()) {
+        try {
+            auto milliseconds = std::stoll(it->second);
+            if (milliseconds < 1) {
+                throw std::out_of_range("time limit");
+            }
+            time_limit = std::chrono::milliseconds(milliseconds);
+        } catch (...) {
+            LOG_ERROR("Processing parameters", "Time limit should be positive integer number of milliseconds");
+            return 1;
+        }
+    }
+
+    it = config.find("--verify");
+    if (it != config.end()) {
+        auto verification_s = it->second;
+        trim(verification_s);
+        to_lower(verification_s);
+        if (verification_s == "none") {
+            VerificationConfig::instance().set(Verification::NONE);
+        } else if (verification_s == "sampled") {
+            VerificationConfig::instance().set(Verification::SAMPLED);
+        } else if (verification_s == "full") {
+            VerificationConfig::instance().set(Verification::FULL);
+        } else {
+            LOG_ERROR("Processing parameters", "Unknown verification mode was provided");
+            return 1;
+        }
+    }
+
+    it = config.find("--database");
+    if (it != config.end()) {
+        auto database = it->second;
+        trim(database);
+        try {
+            prepare_database(database);
+        } catch (const std::exception &e) {
+            LOG_ERROR("Processing parameters", std::string("Unable to prepare optimal database: ") + e.what());
+            return 1;
+        }
+    }
+
+    it = config.find("--cost-model");
+    if (it != config.end()) {
+        auto cost_model = it->second;
+        trim(cost_model);
+        try {
+            CostModel::instance().load(cost_model);
+        } catch (const std::exception &e) {
+            LOG_ERROR("Processing parameters", std::string("Unable to load cost model: ") + e.what());
+            return 1;
+        }
+    }
+
+    it = config.find("--profile");
+    std::string profile;
+    if (it != config.end()) {
+        profile = it->second;
+        trim(profile);
+#ifndef QCS_PROFILING
+        LOG_WARNING("Processing parameters", "The program was built without profiling, all phases will be empty");
+#endif
+    }
+
     LOG_INFO("Starting", "");
     try {
-        process_config(type, algo, reduction, input, output);
+        process_config(type, algo, reduction, input, output, time_limit);
     } catch (const std::exception &e) {
         LOG_ERROR("Finishing", std::string("Unable to handle. An error occurred: ") + e.what());
     }
+    if (!profile.empty()) {
+        std::ofstream file(profile);
+        file << Profiler::instance().to_json();
+        if (!file) {
+            LOG_ERROR("Finishing", "Unable to write profile: " + profile);
+        }
+    }
     LOG_INFO("Finishing", "");
     return 0;
 }
@@ -0,0 +1,100 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_AUTOTUNE_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_AUTOTUNE_HPP
+
+#include <array>
+#include <map>
+#include <mutex>
+
+#include "synthesis.hpp"
+
+// cycles are counted by buckets of length: 1, 2, 3-4, 5-8, 9-16, longer
+static const size_t CYCLE_BUCKETS = 6;
+
+// the constant, dim, dim^2, cycles per point, points per cycle bucket and whether the input was a mapping
+static const size_t FEATURES_NUMBER = 4 + CYCLE_BUCKETS + 1;
+
+// the algorithms Algo::AUTO chooses from
+static const std::array<Algo, 4> AUTO_CANDIDATES = {Algo::GS, Algo::RW, Algo::ZKB, Algo::CA};
+
+// the features of the substitution the algorithms synthesize, an irreversible mapping is taken extended
+struct SynthesisFeatures {
+    size_t dim{};
+    bool is_mapping{};
+    size_t cycles{};
+    std::array<size_t, CYCLE_BUCKETS> cycle_points{};
+
+    [[nodiscard]] std::array<double, FEATURES_NUMBER> vector() const noexcept;
+};
+
+SynthesisFeatures synthesis_features(const Substitution &);
+
+SynthesisFeatures synthesis_features(const BinaryMapping &);
+
+// an observed synthesis the model is fitted by, the time of a failed one is the time until the failure
+struct CostSample {
+    Algo algo;
+    SynthesisFeatures features;
+    double seconds;
+    size_t gates;
+    bool failed;
+};
+
+// log2 of the time and of the number of gates and the probability of a failure, every one is linear in the features
+struct CostPrediction {
+    double log2_seconds;
+    double log2_gates;
+    double failure;
+};
+
+// the cost model of Algo::AUTO: the score of an algorithm is log2 seconds + gates_weight * log2 gates +
+// failure_penalty * failure, the algorithms are tried from the lowest score. An algorithm is not chosen beyond
+// the widest input it was calibrated with, unless every candidate is beyond
+class CostModel {
+public:
+    struct Coefficients {
+        size_t max_dim{};
+        std::array<double, FEATURES_NUMBER> seconds{};
+        std::array<double, FEATURES_NUMBER> gates{};
+        std::array<double, FEATURES_NUMBER> failure{};
+    };
+
+    static CostModel &instance() {
+        static CostModel model;
+        return model;
+    }
+
+    void load(const std::string &);
+
+    void load(std::istream &);
+
+    void save(const std::string &) const;
+
+    void save(std::ostream &) const;
+
+    void set(Algo, const Coefficients &);
+
+    void set_gates_weight(double) noexcept;
+
+    void set_failure_penalty(double) noexcept;
+
+    [[nodiscard]] CostPrediction predict(Algo, const SynthesisFeatures &) const;
+
+    [[nodiscard]] std::vector<Algo> rank(const SynthesisFeatures &) const;
+
+    // ridge least squares over the samples of every candidate
+    static std::map<Algo, Coefficients> fit(const std::vector<CostSample> &);
+
+private:
+    std::map<Algo, Coefficients> coefficients_;
+    double gates_weight_ = 1;
+    double failure_penalty_ = 8;
+    mutable std::mutex mutex_;
+
+    CostModel();
+};
+
+Circuit AUTO_algorithm(const BinaryMapping &, bool = false);
+
+Circuit AUTO_algorithm(const Substitution &, bool = false);
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_AUTOTUNE_HPP
@@ -0,0 +1,75 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_CACHE_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_CACHE_HPP
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+template<typename Key, typename Value>
+class LRUCache {
+public:
+    explicit LRUCache(size_t capacity) : capacity_(capacity) {}
+
+    std::optional<Value> get(const Key &key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return std::nullopt;
+        }
+        items_.splice(items_.begin(), items_, it->second);
+        return it->second->second;
+    }
+
+    void put(const Key &key, const Value &value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!capacity_) {
+            return;
+        }
+        if (auto it = index_.find(key); it != index_.end()) {
+            it->second->second = value;
+            items_.splice(items_.begin(), items_, it->second);
+            return;
+        }
+        if (items_.size() == capacity_) {
+            index_.erase(items_.back().first);
+            items_.pop_back();
+        }
+        items_.emplace_front(key, value);
+        index_.emplace(key, items_.begin());
+    }
+
+    [[nodiscard]] size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return items_.size();
+    }
+
+    [[nodiscard]] size_t capacity() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capacity_;
+    }
+
+    void set_capacity(size_t capacity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        capacity_ = capacity;
+        while (items_.size() > capacity_) {
+            index_.erase(items_.back().first);
+            items_.pop_back();
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        items_.clear();
+        index_.clear();
+    }
+
+private:
+    size_t capacity_;
+    std::list<std::pair<Key, Value>> items_;
+    std::map<Key, typename std::list<std::pair<Key, Value>>::iterator> index_;
+    mutable std::mutex mutex_;
+};
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_CACHE_HPP
@@ -3,6 +3,8 @@
 
 #include <filesystem>
 
+#include "autotune.hpp"
+#include "database.hpp"
 #include "exseptions.hpp"
 #include "logger.hpp"
 #include "synthesis.hpp"
@@ -48,8 +50,22 @@ void write_result(const std::string &output_path, const T &result) {
     file.close();
 }
 
+void prepare_database(const std::string &path) {
+    if (std::filesystem::exists(path)) {
+        LOG_INFO("Loading optimal database", path);
+        OptimalDatabase::instance().load(path);
+        return;
+    }
+    LOG_INFO("Building optimal database", path);
+    for (size_t dim = 1; dim <= OPT_MAX_DIM; dim++) {
+        OptimalDatabase::instance().build(dim);
+    }
+    OptimalDatabase::instance().save(path);
+}
+
 void process_config(InputType type, Algo algo, bool reduction,
-                    const std::string &input_path, const std::string &output_path) {
+                    const std::string &input_path, const std::string &output_path,
+                    std::chrono::milliseconds time_limit = std::chrono::milliseconds(0)) {
     if (input_path.empty()) {
         throw ArgumentException("Path to input file was not provided");
     }
@@ -97,21 +113,34 @@ void process_config(InputType type, Algo algo, bool reduction,
     }
 
     LOG_INFO("Starting quantum circuit synthesis", "");
-    if (type == InputType::TABLE) {
-        BinaryMapping bm(file_content);
-        Circuit c = synthesize(bm, algo, reduction);
-        if (c.memory() && algo == Algo::RW) {
-            LOG_WARNING("Performing quantum circuit synthesis", "Provided binary mapping is not reversible");
+    StopCondition condition;
+    if (time_limit.count()) {
+        condition.set_timeout(time_limit);
+    }
+    try {
+        if (type == InputType::TABLE) {
+            BinaryMapping bm(file_content);
+            Circuit c = synthesize(bm, algo, reduction, condition);
+            if (c.memory() && algo == Algo::RW) {
+                LOG_WARNING("Performing quantum circuit synthesis", "Provided binary mapping is not reversible");
+                LOG_WARNING("Performing quantum circuit synthesis",
+                            "Resulting quantum circuit will have additional memory");
+            }
+            write_result<Circuit>(output_path, c);
+        } else if (type == InputType::SUBSTITUTION) {
+            Substitution sub(file_content);
+            Circuit c = synthesize(sub, algo, reduction, condition);
+            write_result<Circuit>(output_path, c);
+        } else {
+            throw ArgumentException("Unknown type of input");
+        }
+    } catch (const TimeoutException &e) {
+        if (e.partial()) {
             LOG_WARNING("Performing quantum circuit synthesis",
-                        "Resulting quantum circuit will have additional memory");
+                        "The partial circuit has " + std::to_string(e.partial()->complexity()) + " gates: " +
+                        static_cast<std::string>(*e.partial()));
         }
-        write_result<Circuit>(output_path, c);
-    } else if (type == InputType::SUBSTITUTION) {
-        Substitution sub(file_content);
-        Circuit c = synthesize(sub, algo, reduction);
-        write_result<Circuit>(output_path, c);
-    } else {
-        throw ArgumentException("Unknown type of input");
+        throw;
     }
     LOG_INFO("Finishing quantum circuit synthesis", "");
 }
@@ -0,0 +1,55 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_DATABASE_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_DATABASE_HPP
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "synthesis.hpp"
+
+// for 4 lines there are 16! (about 2e13) substitutions, so the exhaustive database stops at 3 lines
+static const size_t OPT_MAX_DIM = 3;
+
+class OptimalDatabase {
+public:
+    static OptimalDatabase &instance() {
+        static OptimalDatabase database;
+        return database;
+    }
+
+    void build(size_t);
+
+    [[nodiscard]] bool contains(size_t) noexcept;
+
+    [[nodiscard]] Circuit circuit(const Substitution &);
+
+    void save(const std::string &);
+
+    void load(const std::string &);
+
+    void clear() noexcept;
+
+private:
+    // last_gates[rank] is index + 1 of the last gate of an optimal circuit for the substitution of this rank,
+    // zero for the identity
+    struct Table {
+        std::vector<Gate> gates;
+        std::vector<std::vector<size_t>> gates_images;
+        std::vector<uint8_t> last_gates;
+    };
+
+    // readers keep a snapshot of the table, so build, load and clear replace the pointers while they run
+    std::array<std::shared_ptr<const Table>, OPT_MAX_DIM + 1> tables_;
+    std::mutex mutex_;
+
+    OptimalDatabase() = default;
+
+    std::shared_ptr<const Table> table_(size_t);
+
+    static Table build_(size_t);
+
+    static Table gates_(size_t);
+};
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_DATABASE_HPP
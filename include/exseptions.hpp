@@ -132,6 +132,23 @@ private:
     std::string message_;
 };
 
+// a synthesis stopped by its StopCondition (stop.hpp)
+class CancelledException : public std::exception {
+public:
+    CancelledException() = default;
+
+    explicit CancelledException(const std::string &message) {
+        message_ = message;
+    }
+
+    [[nodiscard]] const char *what() const noexcept override {
+        return message_.c_str();
+    }
+
+private:
+    std::string message_;
+};
+
 class MathException : public std::exception {
 public:
     MathException() = default;
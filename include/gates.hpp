@@ -1,7 +1,10 @@
 #ifndef QUANTUM_CIRCUIT_SYNTHESIS_GATES_HPP
 #define QUANTUM_CIRCUIT_SYNTHESIS_GATES_HPP
 
+#include <array>
+#include <cassert>
 #include <set>
+#include <span>
 #include <unordered_map>
 
 #include "primitives.hpp"
@@ -24,6 +27,9 @@ using controls_type = std::map<size_t, bool>;
 
 class Circuit;
 
+// circuits up to this number of lines are simulated by kernels specialized for their width
+static const size_t KERNEL_MAX_DIM = 16;
+
 class Gate {
 public:
     // TODO для валидации вентиля, для функции генерации вентилей создать статичные лямбды, которые бы валидацию проводили:
@@ -57,6 +63,9 @@ public:
 
     void act(cf_set &) const;
 
+    // the caller guarantees the set matches the Gate dimension, checked only in debug builds
+    void act_unchecked(cf_set &) const noexcept;
+
     [[nodiscard]] Substitution act() const noexcept;
 
     bool operator==(const Gate &) const;
@@ -75,6 +84,16 @@ private:
 
     friend struct std::hash<Gate>;
 
+    // the gate on a packed row, line i is bit (dim - i - 1)
+    struct RowMask {
+        uint64_t controls_mask;
+        uint64_t controls_values;
+        uint64_t nests_mask;
+        bool is_swap;
+    };
+
+    [[nodiscard]] RowMask row_mask_() const noexcept;
+
     void validate_() const;
 
     void init_(GateType, const std::vector<size_t> &, const controls_type &, size_t);
@@ -124,8 +143,14 @@ public:
 
     void act(cf_set &) const;
 
+    [[nodiscard]] uint64_t act(uint64_t) const;
+
+    void act(std::span<uint64_t>) const;
+
     void add(const Gate &);
 
+    void add(std::vector<Gate> &&);
+
     void insert(const Gate &, size_t = 0);
 
     void inject(const Circuit &);
@@ -149,6 +174,23 @@ private:
     size_t memory_{};
     std::vector<Gate> gates_;
 
+    // gate flattened for the simulation kernels, controls hold the lines and their polarity
+    struct KernelGate {
+        GateType type;
+        size_t nest;
+        size_t other_nest;
+        size_t controls_number;
+        std::array<std::pair<size_t, bool>, KERNEL_MAX_DIM> controls;
+    };
+
+    template<size_t N>
+    static void act_kernel_(const std::vector<KernelGate> &, cf_set &) noexcept;
+
+    [[nodiscard]] std::vector<Gate::RowMask> row_masks_() const;
+
+    // act on the packed rows without a profiling scope, a single row is simulated that way
+    void act_rows_(std::span<uint64_t>) const;
+
     std::vector<std::pair<size_t, size_t>> split_circuit_(size_t &) noexcept;
 
     void by_string_(const std::string &);
@@ -0,0 +1,74 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_JOBS_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_JOBS_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "stop.hpp"
+
+class JobsConfig {
+public:
+    static JobsConfig &instance() {
+        static JobsConfig config;
+        return config;
+    }
+
+    size_t set(size_t jobs) {
+        const auto max_jobs = std::thread::hardware_concurrency();
+        if (jobs > max_jobs) {
+            jobs = max_jobs;
+        }
+        std::atomic_ref(jobs_).store(jobs);
+        return jobs;
+    }
+
+    [[nodiscard]] size_t get() const {
+        return std::atomic_ref(jobs_).load();
+    }
+
+private:
+    JobsConfig() = default;
+
+    size_t jobs_ = 1;
+};
+
+// set in the workers of parallel_for_each: a loop nested into a task runs in its worker, the outer loop already
+// occupies the JobsConfig threads
+inline thread_local bool inside_parallel_task = false;
+
+// runs task(i) for every i of the order on JobsConfig workers, a free worker takes the next index. The workers poll
+// the stop condition of the calling thread
+template<typename Task>
+void parallel_for_each(const std::vector<size_t> &order, Task task) {
+    if (inside_parallel_task) {
+        for (auto i: order) {
+            task(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next = 0;
+    const auto *stop = current_stop_condition;
+    auto process = [&]() {
+        StopScope scope(stop);
+        inside_parallel_task = true;
+        for (size_t i = next++; i < order.size(); i = next++) {
+            task(order[i]);
+        }
+        inside_parallel_task = false;
+    };
+
+    size_t num_threads = std::min(JobsConfig::instance().get(), order.size());
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < num_threads; i++) {
+        futures.push_back(std::async(std::launch::async, process));
+    }
+    for (auto &future: futures) {
+        future.get();
+    }
+}
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_JOBS_HPP
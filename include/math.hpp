@@ -4,7 +4,9 @@
 #include <algorithm>
 #include <bitset>
 #include <cmath>
+#include <numeric>
 #include <string>
+#include <vector>
 
 #include "exseptions.hpp"
 
@@ -101,4 +103,53 @@ inline std::vector<size_t> bits_mask(T a, size_t base) noexcept {
     return bits;
 }
 
+inline size_t factorial(size_t n) {
+    if (n > 20) {
+        throw MathException("Factorial does not fit into 64 bits: " + std::to_string(n));
+    }
+    size_t result = 1;
+    for (size_t i = 2; i <= n; i++) {
+        result *= i;
+    }
+    return result;
+}
+
+template<typename T = size_t>
+inline size_t permutation_rank(const std::vector<T> &p) {
+    // lexicographic rank (Lehmer code), the order of std::next_permutation
+    if (p.size() > 20) {
+        throw MathException("Permutation rank does not fit into 64 bits");
+    }
+    size_t rank = 0;
+    for (size_t i = 0; i < p.size(); i++) {
+        size_t smaller = 0;
+        for (size_t j = i + 1; j < p.size(); j++) {
+            smaller += p[j] < p[i];
+        }
+        rank = rank * (p.size() - i) + smaller;
+    }
+    return rank;
+}
+
+template<typename T = size_t>
+inline std::vector<T> permutation_by_rank(size_t rank, size_t n) {
+    if (rank >= factorial(n)) {
+        throw MathException("Permutation rank out of range: " + std::to_string(rank));
+    }
+    std::vector<size_t> digits(n);
+    for (size_t i = 1; i <= n; i++) {
+        digits[n - i] = rank % i;
+        rank /= i;
+    }
+    std::vector<T> rest(n);
+    std::iota(rest.begin(), rest.end(), 0);
+    std::vector<T> p;
+    p.reserve(n);
+    for (auto digit: digits) {
+        p.push_back(rest[digit]);
+        rest.erase(rest.begin() + static_cast<std::ptrdiff_t>(digit));
+    }
+    return p;
+}
+
 #endif //QUANTUM_CIRCUIT_SYNTHESIS_MATH_HPP
@@ -0,0 +1,80 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_MITM_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_MITM_HPP
+
+#include <cstdint>
+
+#include "synthesis.hpp"
+
+// a substitution of at most 16 points is packed into 64 bits, image i in bits [4i, 4i + 4)
+static const size_t MITM_MAX_DIM = 4;
+
+static const size_t MITM_MEMORY_BUDGET = size_t(1) << 30;
+
+uint64_t pack_substitution(const Substitution &);
+
+Substitution unpack_substitution(uint64_t, size_t);
+
+// open addressing with linear probing over packed substitutions, every key keeps only the index of the gate it was
+// reached by: gates are involutions, so the key followed by that gate is the key it was reached from. ~0 is never
+// a key: it packs a mapping of every point to 15
+class PackedSubstitutionTable {
+public:
+    static constexpr uint64_t EMPTY_KEY = ~uint64_t(0);
+
+    explicit PackedSubstitutionTable(size_t = 1024);
+
+    // false if the key is already there
+    bool insert(uint64_t, uint8_t);
+
+    // the gate the key was reached by
+    [[nodiscard]] const uint8_t *find(uint64_t) const noexcept;
+
+    [[nodiscard]] size_t size() const noexcept;
+
+    [[nodiscard]] size_t bytes() const noexcept;
+
+    // the bytes of the table after it grows for that many more keys
+    [[nodiscard]] size_t bytes_for(size_t) const noexcept;
+
+    void reserve(size_t);
+
+private:
+    std::vector<uint64_t> keys_;
+    std::vector<uint8_t> gates_;
+    size_t size_ = 0;
+
+    [[nodiscard]] size_t slot_(uint64_t) const noexcept;
+
+    [[nodiscard]] static size_t capacity_for_(size_t) noexcept;
+};
+
+class MITMConfig {
+public:
+    static MITMConfig &instance() {
+        static MITMConfig config;
+        return config;
+    }
+
+    void set_memory_budget(size_t bytes) noexcept {
+        memory_budget_.store(bytes);
+    }
+
+    [[nodiscard]] size_t memory_budget() const noexcept {
+        return memory_budget_.load();
+    }
+
+private:
+    MITMConfig() = default;
+
+    std::atomic<size_t> memory_budget_ = MITM_MEMORY_BUDGET;
+};
+
+// breadth-first search from the identity and from the substitution over generate_all_gates(dim), the smaller
+// frontier is expanded on JobsConfig workers. The first meeting gives a circuit with the least number of gates.
+// A layer that does not fit into the memory budget of MITMConfig is still searched for a meeting, the search
+// fails only if it would have to go on beyond it
+Circuit MITM_algorithm(const BinaryMapping &, bool = false);
+
+Circuit MITM_algorithm(const Substitution &, bool = false);
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_MITM_HPP
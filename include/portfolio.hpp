@@ -0,0 +1,51 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_PORTFOLIO_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_PORTFOLIO_HPP
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+#include "synthesis.hpp"
+
+// the portfolio keeps the circuit with the least metric, Circuit::complexity when none is set
+using circuit_metric = std::function<double(const Circuit &)>;
+
+// fast algorithms which never fail go first: with fewer workers than algorithms their circuits bound the others
+static const std::vector<Algo> PORTFOLIO_ALGORITHMS = {Algo::ZKB, Algo::CA, Algo::GS, Algo::RW};
+
+// the algorithms race on JobsConfig workers under a shared deadline. Without reduction and with the default
+// metric a racer is cancelled as soon as its partial circuit is not shorter than the best finished one
+class PortfolioConfig {
+public:
+    static PortfolioConfig &instance() {
+        static PortfolioConfig config;
+        return config;
+    }
+
+    void set_algorithms(const std::vector<Algo> &);
+
+    [[nodiscard]] std::vector<Algo> algorithms() const;
+
+    // zero means no deadline
+    void set_timeout(std::chrono::milliseconds) noexcept;
+
+    [[nodiscard]] std::chrono::milliseconds timeout() const noexcept;
+
+    void set_metric(circuit_metric);
+
+    [[nodiscard]] circuit_metric metric() const;
+
+private:
+    std::vector<Algo> algorithms_ = PORTFOLIO_ALGORITHMS;
+    std::chrono::milliseconds timeout_{0};
+    circuit_metric metric_;
+    mutable std::mutex mutex_;
+
+    PortfolioConfig() = default;
+};
+
+Circuit PORTFOLIO_algorithm(const BinaryMapping &, bool = false);
+
+Circuit PORTFOLIO_algorithm(const Substitution &, bool = false);
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_PORTFOLIO_HPP
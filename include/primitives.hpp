@@ -2,6 +2,9 @@
 #define QUANTUM_CIRCUIT_SYNTHESIS_PRIMITIVES_HPP
 
 #include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -9,11 +12,14 @@
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
+#include <variant>
 #include <vector>
 
 #include "exseptions.hpp"
 #include "math.hpp"
+#include "profiler.hpp"
 #include "strings.hpp"
 
 
@@ -66,8 +72,14 @@ public:
 
     [[nodiscard]] size_t variable() const;
 
+    // true if the function is x_n (or its negation), no function is constructed for the comparison
+    [[nodiscard]] bool is_variable(size_t, bool = false) const noexcept;
+
     [[nodiscard]] std::vector<bool> mobius_transformation() const noexcept;
 
+    // monomials of the ANF as masks of variables: bit (dim - n - 1) stands for x_n
+    [[nodiscard]] std::vector<size_t> monomials() const noexcept;
+
     [[nodiscard]] std::vector<int> RW_spectrum() const noexcept;
 
     [[nodiscard]] int adjacent_zeros() const noexcept;
@@ -78,12 +90,34 @@ public:
 
     [[nodiscard]] binary_vector vector() const noexcept;
 
+    [[nodiscard]] bool value(size_t) const;
+
     [[nodiscard]] std::string to_table(char = '\t') const noexcept;
 
     friend std::ostream &operator<<(std::ostream &, const BooleanFunction &) noexcept;
 
 private:
-    binary_vector vec_;
+    friend class BinaryMapping;
+
+    friend class Gate;
+
+    friend class Circuit;
+
+    // values packed by 64 per word, value i is bit (i % 64) of word i / 64; unused bits of the last word are zero
+    size_t size_{};
+    std::vector<uint64_t> words_;
+
+    [[nodiscard]] bool bit_(size_t) const noexcept;
+
+    void set_bit_(size_t, bool) noexcept;
+
+    void resize_(size_t);
+
+    void clear_tail_() noexcept;
+
+    [[nodiscard]] std::vector<uint64_t> mobius_words_() const noexcept;
+
+    [[nodiscard]] uint64_t variable_word_(size_t, size_t) const noexcept;
 };
 
 BooleanFunction operator+(const BooleanFunction &, const BooleanFunction &);
@@ -96,6 +130,13 @@ using cf_set = std::vector<BooleanFunction>;
 
 class Substitution;
 
+// BENNETT - x, y -> x, y + f(x), as many additional lines as outputs;
+// MINIMAL_GARBAGE - outputs on the last lines and ceil(log2(max output multiplicity)) garbage lines above them
+enum class Embedding {
+    BENNETT,
+    MINIMAL_GARBAGE,
+};
+
 class BinaryMapping {
 public:
     explicit BinaryMapping(const cf_set &);
@@ -130,7 +171,10 @@ public:
 
     [[nodiscard]] bool is_substitution() const noexcept;
 
-    [[nodiscard]] BinaryMapping extend() const;
+    // outputs of the row packed as the Circuit rows, output i is bit (outputs - i - 1)
+    [[nodiscard]] uint64_t row(size_t) const;
+
+    [[nodiscard]] BinaryMapping extend(Embedding = Embedding::BENNETT) const;
 
     [[nodiscard]] std::string to_table(char = '\t') const noexcept;
 
@@ -141,12 +185,33 @@ private:
 
     [[nodiscard]] table to_table_() const noexcept;
 
+    [[nodiscard]] BinaryMapping minimal_extend_() const;
+
     void by_string_(const std::string &);
 };
 
+// rows of the Bennett embedding x, y -> x, y + f(x) computed on demand, the same embedding
+// BinaryMapping::extend() builds for irreversible mappings with several outputs
+class ExtensionView {
+public:
+    explicit ExtensionView(const BinaryMapping &);
+
+    [[nodiscard]] size_t inputs_number() const noexcept;
+
+    [[nodiscard]] size_t outputs_number() const noexcept;
+
+    [[nodiscard]] uint64_t row(size_t) const;
+
+private:
+    BinaryMapping bm_;
+};
+
 using cycle_type = std::vector<size_t>;
 using transposition_type = std::pair<size_t, size_t>;
 
+// images in the narrowest type holding every point: substitutions up to 2^8 points take a byte per point
+using packed_images = std::variant<std::vector<uint8_t>, std::vector<uint16_t>, std::vector<uint32_t>>;
+
 size_t cayley_distance(const Substitution &, const Substitution &);
 
 class Substitution {
@@ -191,11 +256,19 @@ public:
 
     [[nodiscard]] std::vector<size_t> vector() const noexcept;
 
+    [[nodiscard]] size_t image(size_t) const;
+
     [[nodiscard]] std::vector<transposition_type> transpositions() const noexcept;
 
     [[nodiscard]] std::vector<cycle_type> cycles() const noexcept;
 
-    [[nodiscard]] Substitution invert() const noexcept;
+    // fixed points included, without building the cycles
+    [[nodiscard]] size_t cycles_number() const;
+
+    [[nodiscard]] Substitution invert() const;
+
+    // the inverse is scattered into a buffer of the thread, which takes the current images in exchange
+    Substitution &invert_in_place();
 
     [[nodiscard]] bool is_odd() const noexcept;
 
@@ -205,16 +278,32 @@ public:
 
     friend Substitution substitution_power_of_2_by_cycle(const cycle_type &);
 
+    friend size_t cayley_distance(const Substitution &, const Substitution &);
+
+    friend struct std::hash<Substitution>;
+
 private:
-    std::vector<size_t> sub_;
+    packed_images sub_;
+
+    void assign_(const std::vector<size_t> &);
 
     void by_string_(const std::string &);
 };
 
+// a wyhash-style mix over the packed images, up to 16 points take two multiplications
+template<>
+struct std::hash<Substitution> {
+    size_t operator()(const Substitution &) const noexcept;
+};
+
 Substitution operator*(const Substitution &, const Substitution &);
 
 Substitution substitution_by_cycle(const cycle_type &);
 
 Substitution substitution_power_of_2_by_cycle(const cycle_type &);
 
+size_t substitution_rank(const Substitution &);
+
+Substitution substitution_by_rank(size_t, size_t);
+
 #endif //QUANTUM_CIRCUIT_SYNTHESIS_PRIMITIVES_HPP
@@ -0,0 +1,188 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_PROFILER_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+// the instrumentation is compiled out unless QCS_PROFILING is defined (the BUILD_PROFILING option)
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_NAME_(line) PROFILE_CONCAT_(profile_timer_, line)
+#ifdef QCS_PROFILING
+#define PROFILE_SCOPE(phase)    ScopedTimer PROFILE_NAME_(__LINE__)(phase)
+#define PROFILE_COUNT(phase, n) Profiler::instance().count(phase, n)
+#else
+#define PROFILE_SCOPE(phase)    ((void) 0)
+#define PROFILE_COUNT(phase, n) ((void) 0)
+#endif
+
+enum class Phase {
+    SYNTHESIS,
+    GATE_GENERATION,
+    CANDIDATE_SCORING,
+    SIMULATION,
+    VERIFICATION,
+    REDUCTION,
+    PARSING,
+    FORMATTING,
+    PHASES_NUMBER,
+};
+
+class Profiler {
+public:
+    struct Record {
+        uint64_t calls = 0;
+        uint64_t nanoseconds = 0;
+        uint64_t items = 0;
+    };
+
+    static constexpr size_t PHASES_NUMBER = static_cast<size_t>(Phase::PHASES_NUMBER);
+
+    static Profiler &instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    void add(Phase phase, uint64_t nanoseconds) noexcept {
+        auto &counters = local_().counters[static_cast<size_t>(phase)];
+        counters.calls.fetch_add(1, std::memory_order_relaxed);
+        counters.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    void count(Phase phase, uint64_t items) noexcept {
+        local_().counters[static_cast<size_t>(phase)].items.fetch_add(items, std::memory_order_relaxed);
+    }
+
+    // sums over the live threads and the finished ones
+    [[nodiscard]] std::array<Record, PHASES_NUMBER> records() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto result = retired_;
+        for (const auto &buffer: buffers_) {
+            for (size_t i = 0; i < PHASES_NUMBER; i++) {
+                result[i].calls += buffer->counters[i].calls.load(std::memory_order_relaxed);
+                result[i].nanoseconds += buffer->counters[i].nanoseconds.load(std::memory_order_relaxed);
+                result[i].items += buffer->counters[i].items.load(std::memory_order_relaxed);
+            }
+        }
+        return result;
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        retired_ = {};
+        for (const auto &buffer: buffers_) {
+            for (auto &counters: buffer->counters) {
+                counters.calls.store(0, std::memory_order_relaxed);
+                counters.nanoseconds.store(0, std::memory_order_relaxed);
+                counters.items.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    [[nodiscard]] std::string to_json() const {
+        const auto phases_records = records();
+        std::stringstream ss;
+        ss << "{\n";
+        for (size_t i = 0; i < PHASES_NUMBER; i++) {
+            ss << "  \"" << to_string(static_cast<Phase>(i)) << "\": {\"calls\": " << phases_records[i].calls
+               << ", \"seconds\": " << static_cast<double>(phases_records[i].nanoseconds) / 1e9
+               << ", \"items\": " << phases_records[i].items << '}' << (i + 1 < PHASES_NUMBER ? ",\n" : "\n");
+        }
+        ss << "}\n";
+        return ss.str();
+    }
+
+    static std::string to_string(Phase phase) {
+        switch (phase) {
+            case Phase::SYNTHESIS:
+                return "synthesis";
+            case Phase::GATE_GENERATION:
+                return "gate_generation";
+            case Phase::CANDIDATE_SCORING:
+                return "candidate_scoring";
+            case Phase::SIMULATION:
+                return "simulation";
+            case Phase::VERIFICATION:
+                return "verification";
+            case Phase::REDUCTION:
+                return "reduction";
+            case Phase::PARSING:
+                return "parsing";
+            case Phase::FORMATTING:
+                return "formatting";
+            default:
+                return "unknown";
+        }
+    }
+
+private:
+    struct Counters {
+        std::atomic<uint64_t> calls = 0;
+        std::atomic<uint64_t> nanoseconds = 0;
+        std::atomic<uint64_t> items = 0;
+    };
+
+    // written only by its thread, so the relaxed increments never contend
+    struct Buffer {
+        std::array<Counters, PHASES_NUMBER> counters;
+    };
+
+    // registers the buffer of a thread and folds it into the retired records when the thread ends
+    struct LocalBuffer {
+        std::shared_ptr<Buffer> buffer = std::make_shared<Buffer>();
+
+        LocalBuffer() {
+            auto &profiler = Profiler::instance();
+            std::lock_guard<std::mutex> lock(profiler.mutex_);
+            profiler.buffers_.push_back(buffer);
+        }
+
+        ~LocalBuffer() {
+            auto &profiler = Profiler::instance();
+            std::lock_guard<std::mutex> lock(profiler.mutex_);
+            for (size_t i = 0; i < PHASES_NUMBER; i++) {
+                profiler.retired_[i].calls += buffer->counters[i].calls.load(std::memory_order_relaxed);
+                profiler.retired_[i].nanoseconds += buffer->counters[i].nanoseconds.load(std::memory_order_relaxed);
+                profiler.retired_[i].items += buffer->counters[i].items.load(std::memory_order_relaxed);
+            }
+            profiler.buffers_.remove(buffer);
+        }
+    };
+
+    std::list<std::shared_ptr<Buffer>> buffers_;
+    std::array<Record, PHASES_NUMBER> retired_{};
+    mutable std::mutex mutex_;
+
+    Profiler() = default;
+
+    static Buffer &local_() {
+        thread_local LocalBuffer local;
+        return *local.buffer;
+    }
+};
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Phase phase) : phase_(phase), start_(std::chrono::steady_clock::now()) {}
+
+    ScopedTimer(const ScopedTimer &) = delete;
+
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    ~ScopedTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        Profiler::instance().add(phase_, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    Phase phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_PROFILER_HPP
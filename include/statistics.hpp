@@ -1,91 +1,97 @@
 #ifndef QUANTUM_CIRCUIT_SYNTHESIS_STATISTICS_HPP
 #define QUANTUM_CIRCUIT_SYNTHESIS_STATISTICS_HPP
 
+#include <cstdint>
+#include <iostream>
+#include <map>
+
 #include "synthesis.hpp"
 
-void generate_substitution(size_t n, Circuit (*synt_algo)(const Substitution &, bool),
-                           std::vector<std::tuple<size_t, size_t, size_t, std::chrono::microseconds>> &statistic) {
-    std::vector<size_t> sub(n);
-    for (size_t i = 0; i < n; i++) {
-        sub[i] = i;
-    }
-    size_t failed_count = 0;
-    do {
-        try {
-            auto start = std::chrono::high_resolution_clock::now();
-            auto c = synt_algo(Substitution(sub), true);
-            auto end = std::chrono::high_resolution_clock::now();
-            statistic.emplace_back(c.dim(), c.memory(), c.complexity(),
-                                   duration_cast<std::chrono::microseconds>(end - start));
-        } catch (std::exception &e) {
-            std::cout << e.what() << std::endl;
-            std::cout << Substitution(sub) << std::endl;
-            failed_count++;
-        }
-    } while (std::next_permutation(sub.begin(), sub.end()));
-    std::cout << "Failed: " << failed_count << std::endl;
-}
-
-std::tuple<double, double, double, double> collect_statistics(size_t power, Algo algo) {
-    std::vector<std::tuple<size_t, size_t, size_t, std::chrono::microseconds>> statistic;
-    switch (algo) {
-        case (Algo::DUMMY):
-            generate_substitution(power, dummy_algorithm, statistic);
-            break;
-        case Algo::RW:
-            generate_substitution(power, RW_algorithm, statistic);
-            break;
-        case Algo::GS:
-            generate_substitution(power, GS_algorithm, statistic);
-            break;
-        case Algo::ZKB:
-            generate_substitution(power, ZKB_algorithm, statistic);
-            break;
-        case Algo::CA:
-            generate_substitution(power, CA_algorithm, statistic);
-            break;
-        default:
-            break;
-    }
-
-    size_t dim_sum = 0;
-    size_t ancilla_sum = 0;
-    size_t complexity_sum = 0;
-    std::chrono::microseconds microseconds_sum{0};
-    for (const auto &record: statistic) {
-        dim_sum += std::get<0>(record);
-        ancilla_sum += std::get<1>(record);
-        complexity_sum += std::get<2>(record);
-        microseconds_sum += std::get<3>(record);
-    }
-
-    return {static_cast<double>(dim_sum) / statistic.size(),
-            static_cast<double>(ancilla_sum) / statistic.size(),
-            static_cast<double>(complexity_sum) / statistic.size(),
-            microseconds_sum.count() / statistic.size()};
-}
-
-void collect_statistics() {
-    JobsConfig::instance().set(100);
-    const std::vector<size_t> powers = {2, 4, 8};
-    const std::vector<Algo> algorithms = {Algo::DUMMY, Algo::RW, Algo::GS, Algo::ZKB, Algo::CA};
-
-    for (auto algo: algorithms) {
-        for (auto power: powers) {
-            auto results = collect_statistics(power, algo);
-            std::cout << static_cast<int>(algo) << " algorithm (power is equal " << power << ")"
-                      << std::endl
-                      << "Mean dimension " << std::get<0>(results)
-                      << std::endl
-                      << "Mean additional memory lines count " << std::get<1>(results)
-                      << std::endl
-                      << "Mean complexity " << std::get<2>(results)
-                      << std::endl
-                      << "Mean duration, ms " << std::get<3>(results)
-                      << std::endl
-                      << std::endl;
-        }
-    }
-}
+// (2^dim)! substitutions are enumerated up to 3 lines, the 16! ~ 2.1 * 10^13 substitutions of 4 lines are sampled
+static const size_t EXHAUSTIVE_MAX_DIM = 3;
+
+// substitutions taken by a worker at once
+static const size_t STATISTICS_CHUNK = 256;
+
+// chunks of every worker between two checkpoints
+static const size_t STATISTICS_CHUNKS_PER_ROUND = 16;
+
+// mean and variance by Welford, parts computed by different workers are merged by Chan
+class RunningStatistics {
+public:
+    void add(double) noexcept;
+
+    void merge(const RunningStatistics &) noexcept;
+
+    [[nodiscard]] size_t count() const noexcept;
+
+    [[nodiscard]] double mean() const noexcept;
+
+    // the population variance, zero for less than two values
+    [[nodiscard]] double variance() const noexcept;
+
+    [[nodiscard]] double min() const noexcept;
+
+    [[nodiscard]] double max() const noexcept;
+
+    friend std::ostream &operator<<(std::ostream &, const RunningStatistics &);
+
+    friend std::istream &operator>>(std::istream &, RunningStatistics &);
+
+private:
+    size_t count_{};
+    double mean_{};
+    double m2_{};
+    double min_{};
+    double max_{};
+};
+
+// aggregates of the circuits synthesized for a set of substitutions, no circuit is stored
+class SynthesisStatistics {
+public:
+    void add(const Circuit &, double);
+
+    void add_failure() noexcept;
+
+    void merge(const SynthesisStatistics &);
+
+    // successful and failed syntheses
+    [[nodiscard]] size_t processed() const noexcept;
+
+    [[nodiscard]] size_t failed() const noexcept;
+
+    [[nodiscard]] const RunningStatistics &lines() const noexcept;
+
+    [[nodiscard]] const RunningStatistics &memory() const noexcept;
+
+    [[nodiscard]] const RunningStatistics &gates() const noexcept;
+
+    [[nodiscard]] const RunningStatistics &microseconds() const noexcept;
+
+    // number of circuits with the given number of gates
+    [[nodiscard]] const std::map<size_t, size_t> &gates_histogram() const noexcept;
+
+    [[nodiscard]] std::string to_json() const;
+
+    friend std::ostream &operator<<(std::ostream &, const SynthesisStatistics &);
+
+    friend std::istream &operator>>(std::istream &, SynthesisStatistics &);
+
+private:
+    size_t failed_{};
+    RunningStatistics lines_;
+    RunningStatistics memory_;
+    RunningStatistics gates_;
+    RunningStatistics microseconds_;
+    std::map<size_t, size_t> gates_histogram_;
+};
+
+// all (2^dim)! substitutions: the ranks are split into chunks taken by JobsConfig workers; with a checkpoint file
+// the statistics are saved after every round of chunks and a started run is resumed from it
+SynthesisStatistics exhaustive_statistics(Algo, size_t, bool = false, const std::string & = "");
+
+// the given number of random substitutions, the chunk i is generated from seed + i, so the result does not depend
+// on the number of workers
+SynthesisStatistics sampled_statistics(Algo, size_t, size_t, uint64_t, bool = false, const std::string & = "");
 
 #endif //QUANTUM_CIRCUIT_SYNTHESIS_STATISTICS_HPP
@@ -0,0 +1,98 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_STOP_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_STOP_HPP
+
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+using synthesis_clock = std::chrono::steady_clock;
+
+enum class StopReason {
+    NONE,
+    REQUESTED,
+    DEADLINE,
+    BOUND,
+};
+
+// cooperative cancellation of a synthesis: the algorithms poll the condition between their steps. The condition
+// stops on request, at its deadline, or once a partial circuit has more than bound gates
+class StopCondition {
+public:
+    // the condition also stops with its parent
+    explicit StopCondition(const StopCondition *parent = nullptr) noexcept: parent_(parent) {}
+
+    void request_stop() noexcept {
+        stopped_.store(true);
+    }
+
+    void set_deadline(synthesis_clock::time_point deadline) noexcept {
+        deadline_.store(deadline.time_since_epoch().count());
+    }
+
+    void set_timeout(std::chrono::nanoseconds timeout) noexcept {
+        set_deadline(synthesis_clock::now() + timeout);
+    }
+
+    // a synthesis which already has more gates can not produce a circuit as short, one with as many gates may still
+    // tie with it. The bound only decreases
+    void tighten_bound(size_t gates) noexcept {
+        auto bound = bound_.load();
+        while (gates < bound && !bound_.compare_exchange_weak(bound, gates)) {
+        }
+    }
+
+    [[nodiscard]] size_t bound() const noexcept {
+        return bound_.load();
+    }
+
+    [[nodiscard]] StopReason reason(size_t gates = 0) const noexcept {
+        if (parent_) {
+            if (auto reason = parent_->reason(gates); reason != StopReason::NONE) {
+                return reason;
+            }
+        }
+        if (stopped_.load()) {
+            return StopReason::REQUESTED;
+        }
+        auto deadline = deadline_.load();
+        if (deadline != NO_DEADLINE && synthesis_clock::now().time_since_epoch().count() >= deadline) {
+            return StopReason::DEADLINE;
+        }
+        return gates > bound_.load() ? StopReason::BOUND : StopReason::NONE;
+    }
+
+    [[nodiscard]] bool stop_requested(size_t gates = 0) const noexcept {
+        return reason(gates) != StopReason::NONE;
+    }
+
+private:
+    static constexpr auto NO_DEADLINE = std::numeric_limits<synthesis_clock::rep>::max();
+
+    const StopCondition *parent_;
+    std::atomic<bool> stopped_ = false;
+    std::atomic<synthesis_clock::rep> deadline_ = NO_DEADLINE;
+    std::atomic<size_t> bound_ = std::numeric_limits<size_t>::max();
+};
+
+// the condition the syntheses of this thread poll, set by StopScope
+inline thread_local const StopCondition *current_stop_condition = nullptr;
+
+class StopScope {
+public:
+    explicit StopScope(const StopCondition *condition) noexcept: previous_(current_stop_condition) {
+        current_stop_condition = condition;
+    }
+
+    StopScope(const StopScope &) = delete;
+
+    StopScope &operator=(const StopScope &) = delete;
+
+    ~StopScope() {
+        current_stop_condition = previous_;
+    }
+
+private:
+    const StopCondition *previous_;
+};
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_STOP_HPP
@@ -1,51 +1,166 @@
 #ifndef QUANTUM_CIRCUIT_SYNTHESIS_SYNTHESIS_HPP
 #define QUANTUM_CIRCUIT_SYNTHESIS_SYNTHESIS_HPP
 
-#include <atomic>
-#include <future>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <random>
 
+#include "cache.hpp"
 #include "exseptions.hpp"
 #include "gates.hpp"
+#include "jobs.hpp"
 #include "logger.hpp"
+#include "stop.hpp"
 
-class JobsConfig {
+enum class Algo {
+    DUMMY,
+    RW,
+    GS,
+    ZKB,
+    CA,
+    OPT,
+    // the algorithm is chosen by CostModel (autotune.hpp)
+    AUTO,
+    // several algorithms race, the best circuit is kept (portfolio.hpp)
+    PORTFOLIO,
+    // GS as a beam search of BeamConfig width
+    GS_BEAM,
+    // bidirectional search of the shortest circuit (mitm.hpp)
+    MITM,
+    UNKNOWN = 1024,
+    EMPTY = 2048,
+};
+
+// NATURAL - transpositions along consecutive cycle elements;
+// OPTIMIZED - the cheapest decomposition of every cycle, cycles chained by equal conjugation layers
+enum class TranspositionOrder {
+    NATURAL,
+    OPTIMIZED,
+};
+
+// NONE - the synthesized circuit is trusted; SAMPLED - the circuit is compared with the mapping on random rows;
+// FULL - the whole mapping of the circuit is produced and compared
+enum class Verification {
+    NONE,
+    SAMPLED,
+    FULL,
+};
+
+static const size_t VERIFICATION_SAMPLES = 4096;
+
+class VerificationConfig {
 public:
-    static JobsConfig &instance() {
-        static JobsConfig config;
+    static VerificationConfig &instance() {
+        static VerificationConfig config;
         return config;
     }
 
-    size_t set(size_t jobs) {
-        const auto max_jobs = std::thread::hardware_concurrency();
-        if (jobs > max_jobs) {
-            jobs = max_jobs;
-        }
-        std::atomic_ref(jobs_).store(jobs);
-        return jobs;
+    void set(Verification mode) noexcept {
+        mode_.store(mode);
+    }
+
+    [[nodiscard]] Verification get() const noexcept {
+        return mode_.load();
     }
 
-    [[nodiscard]] size_t get() const {
-        return std::atomic_ref(jobs_).load();
+    void set_samples(size_t samples) noexcept {
+        samples_.store(samples);
+    }
+
+    [[nodiscard]] size_t samples() const noexcept {
+        return samples_.load();
+    }
+
+    // a circuit wrong on the given fraction of rows passes k samples with probability (1 - fraction)^k
+    void set_confidence(double confidence, double fraction) {
+        if (confidence <= 0 || confidence >= 1 || fraction <= 0 || fraction >= 1) {
+            throw SynthException("Confidence and fraction of wrong rows should be in (0, 1)");
+        }
+        set_samples(static_cast<size_t>(std::ceil(std::log(1 - confidence) / std::log(1 - fraction))));
     }
 
 private:
-    JobsConfig() = default;
+    VerificationConfig() = default;
 
-    size_t jobs_ = 1;
+    std::atomic<Verification> mode_ = Verification::FULL;
+    std::atomic<size_t> samples_ = VERIFICATION_SAMPLES;
 };
 
-enum class Algo {
-    DUMMY,
-    RW,
-    GS,
-    ZKB,
-    CA,
-    UNKNOWN = 1024,
-    EMPTY = 2048,
+// GS also polls its stop condition every that many scored candidates, a step over 8 lines scores about 18000
+static const size_t STOP_CHECK_INTERVAL = 1024;
+
+static const size_t GS_BEAM_WIDTH = 8;
+
+class BeamConfig {
+public:
+    static BeamConfig &instance() {
+        static BeamConfig config;
+        return config;
+    }
+
+    void set(size_t width) {
+        if (!width) {
+            throw SynthException("Beam width should be at least 1");
+        }
+        width_.store(width);
+    }
+
+    [[nodiscard]] size_t get() const noexcept {
+        return width_.load();
+    }
+
+private:
+    BeamConfig() = default;
+
+    std::atomic<size_t> width_ = GS_BEAM_WIDTH;
 };
 
+static const size_t ZKB_STAR_THRESHOLD = 64;
+
 static const size_t CA_THRESHOLD = 5;
 
+static const size_t CA_CACHE_CAPACITY = 4096;
+
+// cycle rotated to start from its least element, keyed together with the dimension of its sub-circuit
+using cycle_cache = LRUCache<std::pair<size_t, cycle_type>, Circuit>;
+
+cycle_cache &CA_cache();
+
+// checks the circuit against the mapping as VerificationConfig says, falls back to FULL beyond 64 lines
+// or when there are fewer rows than samples
+bool verify(const Circuit &, const BinaryMapping &);
+
+bool verify(const Circuit &, const Substitution &);
+
+// the deadline of the StopCondition passed, the partial circuit holds the gates built by then where they make
+// sense: the greedy steps of RW and GS, the finished cycles of CA
+class TimeoutException : public CancelledException {
+public:
+    explicit TimeoutException(std::optional<Circuit> partial = std::nullopt)
+            : CancelledException("Synthesis time limit exceeded"), partial_(std::move(partial)) {}
+
+    [[nodiscard]] const std::optional<Circuit> &partial() const noexcept {
+        return partial_;
+    }
+
+private:
+    std::optional<Circuit> partial_;
+};
+
+// throws CancelledException, or TimeoutException past the deadline, once the condition stops, gates is the size of
+// the partial circuit of the synthesis
+void check_stop(const StopCondition *, size_t = 0);
+
+// polls the condition of the thread
+void check_stop(size_t = 0);
+
+// the timeout carries the partial circuit
+void check_stop(const Circuit &);
+
+// the name the command line and the benchmarks give the algorithm
+std::string algo_name(Algo);
+
 size_t count_gates(GateType, size_t, bool = false) noexcept;
 
 std::vector<Gate> generate_all_gates(const std::vector<GateType> &, size_t);
@@ -58,8 +173,16 @@ std::vector<Gate> generate_all_gates(size_t, size_t);
 
 Circuit synthesize(const BinaryMapping &, Algo = Algo::RW, bool = false);
 
+// the dummy algorithm builds its own memory, the others synthesize the chosen embedding of the mapping
+Circuit synthesize(const BinaryMapping &, Algo, bool, Embedding);
+
 Circuit synthesize(const Substitution &, Algo = Algo::RW, bool = false);
 
+// the synthesis polls the condition at its iteration boundaries, see check_stop
+Circuit synthesize(const BinaryMapping &, Algo, bool, const StopCondition &);
+
+Circuit synthesize(const Substitution &, Algo, bool, const StopCondition &);
+
 Circuit dummy_algorithm(const BinaryMapping &, bool = false);
 
 Circuit dummy_algorithm(const Substitution &, bool = false);
@@ -72,12 +195,28 @@ Circuit GS_algorithm(const BinaryMapping &, bool = false);
 
 Circuit GS_algorithm(const Substitution &, bool = false);
 
+// the width best distinct partial circuits by the Cayley distance to the substitution are extended by every gate on
+// JobsConfig workers. Unlike GS a step may bring no closer, power steps in a row without a closer circuit fail
+Circuit GS_beam_algorithm(const BinaryMapping &, size_t = GS_BEAM_WIDTH, bool = false);
+
+Circuit GS_beam_algorithm(const Substitution &, size_t = GS_BEAM_WIDTH, bool = false);
+
 Circuit ZKB_algorithm(const BinaryMapping &, bool = false);
 
 Circuit ZKB_algorithm(const Substitution &, bool = false);
 
+Circuit ZKB_algorithm(const BinaryMapping &, TranspositionOrder, bool = false);
+
+Circuit ZKB_algorithm(const Substitution &, TranspositionOrder, bool = false);
+
 Circuit CA_algorithm(const BinaryMapping &, bool = false);
 
 Circuit CA_algorithm(const Substitution &, bool = false);
 
+Circuit CA_cycle_synthesis(const cycle_type &);
+
+Circuit OPT_algorithm(const BinaryMapping &, bool = false);
+
+Circuit OPT_algorithm(const Substitution &, bool = false);
+
 #endif //QUANTUM_CIRCUIT_SYNTHESIS_SYNTHESIS_HPP
@@ -0,0 +1,330 @@
+#include <fstream>
+#include <limits>
+
+#include "autotune.hpp"
+
+static const std::string COST_MODEL_HEADER = "# cost model";
+
+// a synthesis faster than this is counted as taking it, log2 of zero is undefined
+static const double MIN_SECONDS = 1e-7;
+
+// the regularization keeps the fit defined when a feature does not vary over the samples
+static const double RIDGE_LAMBDA = 1e-1;
+
+// calibrated by benchmarks_synthesis --algos gs,rw,zkb,ca --random 10 --max-width 7 --cost-model FILE
+static const std::string DEFAULT_COST_MODEL = R"(# cost model
+gates_weight 1
+failure_penalty 8
+rw 4 -16.461364490273265 1.5512289024252701 0.16515495531553198 -0.74295989791649419 0.024256020445370553 -1.1598737933626753 -0.79042910018772261 -1.1018282156727952 1.045439406979161 1.9824356817987405 0 0.8715203598908331 0.11235222052319588 0.19140832105933789 -0.18825577034059535 -0.071783787127597296 -0.09911847176555022 -0.036201365247605255 0.18029874709001895 0.026804877050734029 0 0 -1.2301005862506011 0.62866357225153857 -0.045720614213066495 -0.24361214488268368 -0.38731129663919311 0.44451946039338663 -0.24078798252688408 -0.092902390479756819 0.013775054360721423 0.26270715489181906 0
+gs 3 -13.925084077788199 0.022677824098721367 0.31113386713949892 -0.084446662558683175 -0.91645971626635314 -0.065854674774558669 -0.36869296024646764 0.19131453889765823 0.65973199070329869 0.49996082168667849 0 0.86753528773072597 0.028954035468688973 0.11581614187477547 0 0.0036192544335860071 -0.010857763300756064 0.0072385088671720168 0 0 0 0 -0.58720210463556277 0.64698057986313207 -0.062419365256178846 -0.028052585080772317 -0.36151671537158298 0.25425753577399818 -0.040503324930880817 0.24735775187011311 -0.021144858320059148 -0.078450389021471084 0
+zkb 15 -13.893580626192664 0.10974347938810923 0.053302169382613097 0.1346286933074147 0.19940258668160651 0.14401409363115636 -0.0027743526628017674 0.11254260703637656 -0.42678642719919385 -0.026398507486816245 -1.4490137678803559 1.0658600719760964 1.1655309118327899 -0.0016560302867006842 -0.82413736984262143 -1.1688337095333339 0.017918811023028728 -0.1817574371416675 0.40574029648894155 0.30145248491302901 0.62547955424815993 -0.74795866277742218 0.48779366255518081 -0.12823989502996361 0.0063323845224206293 -0.24410800564638768 -0.38417303907603095 0.52962917859407466 -0.12058259400275034 -0.10636169936329554 -0.018445234417905101 0.099933388265866327 -0.25389831142370073
+ca 7 -20.552099465683469 3.7583546189908952 -0.041084437261471068 5.6296403352990474 3.315853729630474 1.7716939763837782 4.6132193202880938 3.3874390013405038 -6.1166369424091025 -6.9715690852306267 0 -0.58578419517883851 1.5000715636144371 -0.026851050278953452 -0.77680617105697314 -1.3350772231290546 -0.020179197426172045 -0.52577145321677932 -0.77832890884347605 1.3821441431665362 1.2772126394486849 0 -0.5550940980563559 0.22975622723523395 -0.017668953925969282 -0.0095535143404751055 -0.06831079498598773 0.19339860730087713 0.18795763636701551 0.050766763783039827 -0.1539897433496703 -0.20982246911522714 0
+)";
+
+std::array<double, FEATURES_NUMBER> SynthesisFeatures::vector() const noexcept {
+    std::array<double, FEATURES_NUMBER> result{};
+    const auto points = static_cast<double>(size_t(1) << dim);
+    result[0] = 1;
+    result[1] = static_cast<double>(dim);
+    result[2] = static_cast<double>(dim * dim);
+    result[3] = static_cast<double>(cycles) / points;
+    for (size_t i = 0; i < CYCLE_BUCKETS; i++) {
+        result[4 + i] = static_cast<double>(cycle_points[i]) / points;
+    }
+    result[4 + CYCLE_BUCKETS] = is_mapping ? 1 : 0;
+    return result;
+}
+
+SynthesisFeatures synthesis_features(const Substitution &sub) {
+    SynthesisFeatures features;
+    features.dim = static_cast<size_t>(std::log2(sub.power()));
+    for (const auto &cycle: sub.cycles()) {
+        features.cycles++;
+        auto bucket = std::min<size_t>(std::bit_width(cycle.size() - 1), CYCLE_BUCKETS - 1);
+        features.cycle_points[bucket] += cycle.size();
+    }
+    return features;
+}
+
+SynthesisFeatures synthesis_features(const BinaryMapping &bm) {
+    if (bm.is_substitution()) {
+        return synthesis_features(Substitution(bm));
+    }
+    auto features = synthesis_features(Substitution(bm.extend()));
+    features.is_mapping = true;
+    return features;
+}
+
+CostModel::CostModel() {
+    std::stringstream ss(DEFAULT_COST_MODEL);
+    load(ss);
+}
+
+void CostModel::load(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw IOException("Unable to open cost model file: " + path);
+    }
+    load(file);
+}
+
+// every line is a parameter or the coefficients of an algorithm: NAME MAX_DIM SECONDS... GATES... FAILURE...
+void CostModel::load(std::istream &in) {
+    std::string line;
+    if (!std::getline(in, line) || line != COST_MODEL_HEADER) {
+        throw IOException("Invalid cost model header");
+    }
+    std::map<Algo, Coefficients> coefficients;
+    double gates_weight = 1;
+    double failure_penalty = 8;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        std::string key;
+        if (!(ss >> key) || key.front() == '#') {
+            continue;
+        }
+        if (key == "gates_weight") {
+            ss >> gates_weight;
+        } else if (key == "failure_penalty") {
+            ss >> failure_penalty;
+        } else {
+            auto it = std::find_if(AUTO_CANDIDATES.begin(), AUTO_CANDIDATES.end(), [&key](Algo algo) {
+                return algo_name(algo) == key;
+            });
+            if (it == AUTO_CANDIDATES.end()) {
+                throw IOException("Unknown algorithm in cost model: " + key);
+            }
+            auto &algo_coefficients = coefficients[*it];
+            ss >> algo_coefficients.max_dim;
+            for (auto *weights: {&algo_coefficients.seconds, &algo_coefficients.gates, &algo_coefficients.failure}) {
+                for (auto &weight: *weights) {
+                    ss >> weight;
+                }
+            }
+        }
+        if (!ss) {
+            throw IOException("Invalid cost model line: " + line);
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    coefficients_ = std::move(coefficients);
+    gates_weight_ = gates_weight;
+    failure_penalty_ = failure_penalty;
+}
+
+void CostModel::save(const std::string &path) const {
+    std::ofstream file(path);
+    save(file);
+    if (!file) {
+        throw IOException("Unable to write cost model file: " + path);
+    }
+}
+
+void CostModel::save(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto precision = out.precision(std::numeric_limits<double>::max_digits10);
+    out << COST_MODEL_HEADER << '\n' << "gates_weight " << gates_weight_ << '\n' << "failure_penalty "
+        << failure_penalty_ << '\n';
+    for (const auto &[algo, algo_coefficients]: coefficients_) {
+        out << algo_name(algo) << ' ' << algo_coefficients.max_dim;
+        for (const auto *weights: {&algo_coefficients.seconds, &algo_coefficients.gates, &algo_coefficients.failure}) {
+            for (auto weight: *weights) {
+                out << ' ' << weight;
+            }
+        }
+        out << '\n';
+    }
+    out.precision(precision);
+}
+
+void CostModel::set(Algo algo, const Coefficients &algo_coefficients) {
+    if (std::find(AUTO_CANDIDATES.begin(), AUTO_CANDIDATES.end(), algo) == AUTO_CANDIDATES.end()) {
+        throw SynthException("Algorithm is not a candidate of the automatic choice");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    coefficients_[algo] = algo_coefficients;
+}
+
+void CostModel::set_gates_weight(double weight) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gates_weight_ = weight;
+}
+
+void CostModel::set_failure_penalty(double penalty) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failure_penalty_ = penalty;
+}
+
+CostPrediction CostModel::predict(Algo algo, const SynthesisFeatures &features) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = coefficients_.find(algo);
+    if (it == coefficients_.end()) {
+        throw SynthException("There is no cost model for the algorithm");
+    }
+    const auto x = features.vector();
+    CostPrediction prediction{};
+    for (size_t i = 0; i < FEATURES_NUMBER; i++) {
+        prediction.log2_seconds += it->second.seconds[i] * x[i];
+        prediction.log2_gates += it->second.gates[i] * x[i];
+        prediction.failure += it->second.failure[i] * x[i];
+    }
+    prediction.failure = std::clamp(prediction.failure, 0., 1.);
+    return prediction;
+}
+
+std::vector<Algo> CostModel::rank(const SynthesisFeatures &features) const {
+    struct Candidate {
+        Algo algo;
+        bool is_calibrated;
+        double score;
+    };
+    std::vector<Candidate> candidates;
+    for (auto algo: AUTO_CANDIDATES) {
+        size_t max_dim = 0;
+        double gates_weight = 0;
+        double failure_penalty = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = coefficients_.find(algo);
+            if (it == coefficients_.end()) {
+                continue;
+            }
+            max_dim = it->second.max_dim;
+            gates_weight = gates_weight_;
+            failure_penalty = failure_penalty_;
+        }
+        auto prediction = predict(algo, features);
+        candidates.push_back({algo, features.dim <= max_dim, prediction.log2_seconds +
+                                                             gates_weight * prediction.log2_gates +
+                                                             failure_penalty * prediction.failure});
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const auto &c1, const auto &c2) {
+        return c1.is_calibrated != c2.is_calibrated ? c1.is_calibrated : c1.score < c2.score;
+    });
+
+    std::vector<Algo> result;
+    for (const auto &candidate: candidates) {
+        result.push_back(candidate.algo);
+    }
+    // an uncalibrated model still tries every candidate, the cheapest ones first
+    for (auto algo: {Algo::CA, Algo::ZKB, Algo::GS, Algo::RW}) {
+        if (std::find(result.begin(), result.end(), algo) == result.end()) {
+            result.push_back(algo);
+        }
+    }
+    return result;
+}
+
+// solves (X^T X + lambda I) w = X^T y by Gaussian elimination
+static std::array<double, FEATURES_NUMBER> least_squares_(const std::vector<std::array<double, FEATURES_NUMBER>> &xs,
+                                                          const std::vector<double> &ys) {
+    const size_t n = FEATURES_NUMBER;
+    std::vector<std::vector<double>> a(n, std::vector<double>(n + 1, 0));
+    for (size_t k = 0; k < xs.size(); k++) {
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                a[i][j] += xs[k][i] * xs[k][j];
+            }
+            a[i][n] += xs[k][i] * ys[k];
+        }
+    }
+    // the constant feature is not regularized, it would bias every prediction
+    for (size_t i = 1; i < n; i++) {
+        a[i][i] += RIDGE_LAMBDA;
+    }
+    for (size_t col = 0; col < n; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n; row++) {
+            if (std::abs(a[row][col]) > std::abs(a[pivot][col])) {
+                pivot = row;
+            }
+        }
+        std::swap(a[col], a[pivot]);
+        for (size_t row = 0; row < n; row++) {
+            if (row == col || a[row][col] == 0) {
+                continue;
+            }
+            auto factor = a[row][col] / a[col][col];
+            for (size_t j = col; j <= n; j++) {
+                a[row][j] -= factor * a[col][j];
+            }
+        }
+    }
+    std::array<double, FEATURES_NUMBER> result{};
+    for (size_t i = 0; i < n; i++) {
+        result[i] = a[i][n] / a[i][i];
+    }
+    return result;
+}
+
+std::map<Algo, CostModel::Coefficients> CostModel::fit(const std::vector<CostSample> &samples) {
+    std::map<Algo, Coefficients> result;
+    for (auto algo: AUTO_CANDIDATES) {
+        std::vector<std::array<double, FEATURES_NUMBER>> xs;
+        std::vector<std::array<double, FEATURES_NUMBER>> succeeded_xs;
+        std::vector<double> seconds;
+        std::vector<double> gates;
+        std::vector<double> failures;
+        Coefficients algo_coefficients;
+        for (const auto &sample: samples) {
+            if (sample.algo != algo) {
+                continue;
+            }
+            xs.push_back(sample.features.vector());
+            seconds.push_back(std::log2(std::max(sample.seconds, MIN_SECONDS)));
+            failures.push_back(sample.failed ? 1 : 0);
+            if (!sample.failed) {
+                succeeded_xs.push_back(xs.back());
+                gates.push_back(std::log2(static_cast<double>(sample.gates) + 1));
+                algo_coefficients.max_dim = std::max(algo_coefficients.max_dim, sample.features.dim);
+            }
+        }
+        if (xs.empty()) {
+            continue;
+        }
+        algo_coefficients.seconds = least_squares_(xs, seconds);
+        algo_coefficients.failure = least_squares_(xs, failures);
+        if (!succeeded_xs.empty()) {
+            algo_coefficients.gates = least_squares_(succeeded_xs, gates);
+        }
+        result[algo] = algo_coefficients;
+    }
+    return result;
+}
+
+static Circuit AUTO_algorithm_(const Substitution &sub, const SynthesisFeatures &features, bool reduction) {
+    std::string errors;
+    for (auto algo: CostModel::instance().rank(features)) {
+        try {
+            return synthesize(sub, algo, reduction);
+        } catch (const CancelledException &) {
+            throw;
+        } catch (const std::exception &e) {
+            LOG_DEBUG("Performing synthesis using the AUTO algorithm",
+                      algo_name(algo) + " failed: " + static_cast<std::string>(e.what()));
+            errors += (errors.empty() ? "" : "; ") + algo_name(algo) + ": " + e.what();
+        }
+    }
+    throw SynthException("Unable to synthesize Circuit by any algorithm: " + errors);
+}
+
+Circuit AUTO_algorithm(const BinaryMapping &bm, bool reduction) {
+    if (bm.is_substitution()) {
+        return AUTO_algorithm(Substitution(bm), reduction);
+    }
+    auto bm_extended = bm.extend();
+    Substitution sub(bm_extended);
+    auto features = synthesis_features(sub);
+    features.is_mapping = true;
+    auto c = AUTO_algorithm_(sub, features, reduction);
+    c.set_memory(bm_extended.inputs_number() - bm.inputs_number());
+    return c;
+}
+
+Circuit AUTO_algorithm(const Substitution &sub, bool reduction) {
+    if (!is_power_of_2(sub.power())) {
+        throw SynthException("Substitution size should be power of 2");
+    }
+    return AUTO_algorithm_(sub, synthesis_features(sub), reduction);
+}
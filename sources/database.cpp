@@ -0,0 +1,223 @@
+#include "database.hpp"
+
+
+static const std::string DATABASE_MAGIC = "QCSOPT";
+static const uint8_t DATABASE_VERSION = 1;
+static const uint8_t UNVISITED = std::numeric_limits<uint8_t>::max();
+
+void OptimalDatabase::build(size_t dim) {
+    if (!dim || dim > OPT_MAX_DIM) {
+        throw SynthException("There is no optimal database for dimension " + std::to_string(dim));
+    }
+    auto dim_table = std::make_shared<const Table>(build_(dim));
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_[dim] = std::move(dim_table);
+}
+
+bool OptimalDatabase::contains(size_t dim) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dim && dim <= OPT_MAX_DIM && tables_[dim];
+}
+
+Circuit OptimalDatabase::circuit(const Substitution &sub) {
+    if (!is_power_of_2(sub.power())) {
+        throw SynthException("Substitution size should be power of 2");
+    }
+    size_t dim = std::log2(sub.power());
+    const auto table_snapshot = table_(dim);
+    const auto &dim_table = *table_snapshot;
+
+    // gates are involutions, so the substitution followed by its last gate is the optimal prefix
+    std::vector<size_t> gates_indices;
+    auto images = sub.vector();
+    while (auto last_gate = dim_table.last_gates[permutation_rank(images)]) {
+        const auto &gate_images = dim_table.gates_images[last_gate - 1];
+        for (auto &image: images) {
+            image = gate_images[image];
+        }
+        gates_indices.push_back(last_gate - 1);
+    }
+
+    Circuit c(dim);
+    for (auto it = gates_indices.rbegin(); it != gates_indices.rend(); it++) {
+        c.add(dim_table.gates[*it]);
+    }
+    return c;
+}
+
+void OptimalDatabase::save(const std::string &path) {
+    decltype(tables_) dim_tables;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dim_tables = tables_;
+    }
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file) {
+        throw IOException("Unable to open database file: " + path);
+    }
+
+    uint8_t tables_number = std::count_if(dim_tables.begin(), dim_tables.end(), [](const auto &dim_table) {
+        return dim_table != nullptr;
+    });
+    file.write(DATABASE_MAGIC.data(), static_cast<std::streamsize>(DATABASE_MAGIC.size()));
+    file.put(static_cast<char>(DATABASE_VERSION));
+    file.put(static_cast<char>(tables_number));
+    for (size_t dim = 1; dim <= OPT_MAX_DIM; dim++) {
+        if (!dim_tables[dim]) {
+            continue;
+        }
+        const auto &last_gates = dim_tables[dim]->last_gates;
+        file.put(static_cast<char>(dim));
+        for (size_t byte = 0; byte < sizeof(uint64_t); byte++) {
+            file.put(static_cast<char>((last_gates.size() >> (byte * 8)) & 0xFF));
+        }
+        file.write(reinterpret_cast<const char *>(last_gates.data()), static_cast<std::streamsize>(last_gates.size()));
+    }
+    if (!file) {
+        throw IOException("Unable to write database file: " + path);
+    }
+}
+
+void OptimalDatabase::load(const std::string &path) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        throw IOException("Unable to open database file: " + path);
+    }
+
+    std::string magic(DATABASE_MAGIC.size(), '\0');
+    file.read(magic.data(), static_cast<std::streamsize>(magic.size()));
+    if (!file || magic != DATABASE_MAGIC) {
+        throw IOException("Invalid database file: " + path);
+    }
+    if (file.get() != DATABASE_VERSION) {
+        throw IOException("Unsupported database version: " + path);
+    }
+    auto tables_number = file.get();
+    if (!file) {
+        throw IOException("Invalid database file: " + path);
+    }
+
+    decltype(tables_) dim_tables;
+    for (int i = 0; i < tables_number; i++) {
+        auto dim = static_cast<size_t>(file.get());
+        if (!file || !dim || dim > OPT_MAX_DIM) {
+            throw IOException("Invalid database dimension: " + path);
+        }
+        size_t states = 0;
+        for (size_t byte = 0; byte < sizeof(uint64_t); byte++) {
+            states |= static_cast<size_t>(static_cast<uint8_t>(file.get())) << (byte * 8);
+        }
+        if (!file || states != factorial(1 << dim)) {
+            throw IOException("Invalid database size: " + path);
+        }
+
+        auto dim_table = gates_(dim);
+        dim_table.last_gates.resize(states);
+        file.read(reinterpret_cast<char *>(dim_table.last_gates.data()), static_cast<std::streamsize>(states));
+        if (!file || std::any_of(dim_table.last_gates.begin(), dim_table.last_gates.end(), [&](auto last_gate) {
+            return last_gate > dim_table.gates.size();
+        })) {
+            throw IOException("Corrupted database table: " + path);
+        }
+        dim_tables[dim] = std::make_shared<const Table>(std::move(dim_table));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t dim = 1; dim <= OPT_MAX_DIM; dim++) {
+        if (dim_tables[dim]) {
+            tables_[dim] = std::move(dim_tables[dim]);
+        }
+    }
+}
+
+void OptimalDatabase::clear() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &dim_table: tables_) {
+        dim_table.reset();
+    }
+}
+
+std::shared_ptr<const OptimalDatabase::Table> OptimalDatabase::table_(size_t dim) {
+    if (!dim || dim > OPT_MAX_DIM) {
+        throw SynthException("There is no optimal database for dimension " + std::to_string(dim));
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!tables_[dim]) {
+        LOG_INFO("Building optimal database", "Dimension " + std::to_string(dim));
+        tables_[dim] = std::make_shared<const Table>(build_(dim));
+    }
+    return tables_[dim];
+}
+
+OptimalDatabase::Table OptimalDatabase::build_(size_t dim) {
+    // breadth-first search from the identity: the first visit of a substitution is an optimal one
+    auto dim_table = gates_(dim);
+    const size_t power = 1 << dim;
+
+    dim_table.last_gates.assign(factorial(power), UNVISITED);
+    dim_table.last_gates[0] = 0;  // rank of the identity
+    std::vector<size_t> frontier{0};
+
+    auto expand = [&](size_t start, size_t end) {
+        std::vector<std::pair<size_t, uint8_t>> found;
+        std::vector<size_t> images(power);
+        for (size_t i = start; i < end; i++) {
+            const auto sub = permutation_by_rank(frontier[i], power);
+            for (size_t g = 0; g < dim_table.gates_images.size(); g++) {
+                for (size_t x = 0; x < power; x++) {
+                    images[x] = dim_table.gates_images[g][sub[x]];
+                }
+                auto rank = permutation_rank(images);
+                if (dim_table.last_gates[rank] == UNVISITED) {
+                    found.emplace_back(rank, g + 1);
+                }
+            }
+        }
+        return found;
+    };
+
+    const size_t num_threads = JobsConfig::instance().get();
+    while (!frontier.empty()) {
+        size_t batch_size = (frontier.size() + num_threads - 1) / num_threads;
+        std::vector<std::future<std::vector<std::pair<size_t, uint8_t>>>> futures;
+        for (size_t i = 0; i < frontier.size(); i += batch_size) {
+            futures.push_back(std::async(std::launch::async, expand, i, std::min(i + batch_size, frontier.size())));
+        }
+        std::vector<std::vector<std::pair<size_t, uint8_t>>> results;
+        for (auto &future: futures) {
+            results.push_back(future.get());
+        }
+
+        std::vector<size_t> next_frontier;
+        for (const auto &found: results) {
+            for (const auto &[rank, last_gate]: found) {
+                if (dim_table.last_gates[rank] == UNVISITED) {
+                    dim_table.last_gates[rank] = last_gate;
+                    next_frontier.push_back(rank);
+                }
+            }
+        }
+        frontier = std::move(next_frontier);
+    }
+
+    if (std::find(dim_table.last_gates.begin(), dim_table.last_gates.end(), UNVISITED) != dim_table.last_gates.end()) {
+        throw SynthException("Gates do not generate all substitutions of dimension " + std::to_string(dim));
+    }
+    return dim_table;
+}
+
+OptimalDatabase::Table OptimalDatabase::gates_(size_t dim) {
+    // the order of gates is a part of the file format, so it must not depend on generate_all_gates internals
+    Table dim_table;
+    dim_table.gates = generate_all_gates(dim);
+    std::sort(dim_table.gates.begin(), dim_table.gates.end(), [](const Gate &g1, const Gate &g2) {
+        return static_cast<std::string>(g1) < static_cast<std::string>(g2);
+    });
+    if (dim_table.gates.size() >= UNVISITED) {
+        throw SynthException("Too many gates for the optimal database");
+    }
+    for (const auto &gate: dim_table.gates) {
+        dim_table.gates_images.push_back(gate.act().vector());
+    }
+    return dim_table;
+}
@@ -1,4 +1,5 @@
 #include "gates.hpp"
+#include "jobs.hpp"
 
 
 Gate::Gate(GateType type, const std::vector<size_t> &nests, const controls_type &controls, size_t dim) {
@@ -288,55 +289,101 @@ void Gate::act(cf_set &vec) const {
     if (vec.size() != dim_) {
         throw GateException("Input coordinate boolean functions vector must have length equals to the Gate dimension");
     }
-    if (!std::all_of(vec.begin(), vec.end(),
-                     [bf_size = std::pow(2, dim_)](const auto &v) {
-                         return v.size() == bf_size;
-                     })) {
+    if (!std::all_of(vec.begin(), vec.end(), [bf_size = size_t(1) << dim_](const auto &v) {
+        return v.size() == bf_size;
+    })) {
         throw GateException("Coordinate boolean functions must have the same dimensions as Gate");
     }
+    act_unchecked(vec);
+}
+
+void Gate::act_unchecked(cf_set &vec) const noexcept {
+    assert(vec.size() == dim_ && controls_.size() <= 64);
+    assert(std::all_of(vec.begin(), vec.end(), [bf_size = size_t(1) << dim_](const auto &v) {
+        return v.size() == bf_size;
+    }));
+
+    auto &nest = vec[nests_.front()].words_;
+    const auto words_number = nest.size();
+    // all ones over the values of word w, the unused tail of the last word stays zero
+    const auto size = vec[nests_.front()].size_;
+    auto ones = [&](size_t w) {
+        return w + 1 == words_number && size % 64 ? (uint64_t(1) << (size % 64)) - 1 : ~uint64_t(0);
+    };
 
     if (type_ == GateType::NOT) {
-        ~vec[nests_.front()];
+        for (size_t w = 0; w < words_number; w++) {
+            nest[w] ^= ones(w);
+        }
     } else if (type_ == GateType::CNOT) {
-        vec[nests_.front()] += vec[controls_.begin()->first] + BooleanFunction(!controls_.begin()->second, dim_);
+        const auto &[num, is_direct] = *controls_.begin();
+        const auto &control = vec[num].words_;
+        for (size_t w = 0; w < words_number; w++) {
+            nest[w] ^= is_direct ? control[w] : control[w] ^ ones(w);
+        }
     } else if (type_ == GateType::kCNOT) {
-        BooleanFunction control_signal(true, dim_);
+        // nest ^= AND of the controls, inverted controls are flipped by their polarity
+        std::array<std::pair<const uint64_t *, bool>, 64> controls;
+        size_t controls_number = 0;
         for (const auto &[num, is_direct]: controls_) {
-            if (!is_direct) {
-                control_signal *= (vec[num] + BooleanFunction(true, dim_));
-            } else {
-                control_signal *= vec[num];
+            controls[controls_number++] = {vec[num].words_.data(), is_direct};
+        }
+        for (size_t w = 0; w < words_number; w++) {
+            auto signal = ones(w);
+            for (size_t i = 0; i < controls_number && signal; i++) {
+                signal &= controls[i].second ? controls[i].first[w] : ~controls[i].first[w];
             }
+            nest[w] ^= signal;
         }
-        vec[nests_.front()] += control_signal;
     } else if (type_ == GateType::SWAP) {
-        vec[nests_.front()] += vec[nests_.back()];
-        vec[nests_.back()] += vec[nests_.front()];
-        vec[nests_.front()] += vec[nests_.back()];
+        std::swap(vec[nests_.front()].words_, vec[nests_.back()].words_);
     } else if (type_ == GateType::CSWAP) {
-        BooleanFunction term = vec[controls_.begin()->first] * (vec[nests_.front()] + vec[nests_.back()]);
-        if (!controls_.begin()->second) {
-            vec[nests_.front()] += vec[nests_.back()];
-            vec[nests_.back()] += vec[nests_.front()];
-            vec[nests_.front()] += vec[nests_.back()];
+        const auto &[num, is_direct] = *controls_.begin();
+        const auto &control = vec[num].words_;
+        auto &other = vec[nests_.back()].words_;
+        for (size_t w = 0; w < words_number; w++) {
+            auto difference = (nest[w] ^ other[w]) & (is_direct ? control[w] : ~control[w]);
+            nest[w] ^= difference;
+            other[w] ^= difference;
         }
-        vec[nests_.front()] += term;
-        vec[nests_.back()] += term;
     }
 }
 
 Substitution Gate::act() const noexcept {
-    // TODO тестировать и оптимизировать
-    Substitution sub(1 << dim_);
-    cf_set sub_cf(BinaryMapping(sub).coordinate_functions());
-    act(sub_cf);
-    return Substitution(sub_cf);
+    const auto [controls_mask, controls_values, nests_mask, is_swap] = row_mask_();
+    std::vector<size_t> images(size_t(1) << dim_);
+    for (size_t x = 0; x < images.size(); x++) {
+        images[x] = x;
+        if ((x & controls_mask) != controls_values) {
+            continue;
+        }
+        // a swap changes the element only if its nest bits differ
+        if (!is_swap || std::popcount(x & nests_mask) == 1) {
+            images[x] ^= nests_mask;
+        }
+    }
+    return Substitution(images);
 }
 
 bool Gate::operator==(const Gate &g) const {
     return (type_ == g.type_ && dim_ && g.dim_ && nests_ == g.nests_ && controls_ == g.controls_);
 }
 
+Gate::RowMask Gate::row_mask_() const noexcept {
+    auto line_bit = [this](size_t line) {
+        return uint64_t(1) << (dim_ - line - 1);
+    };
+    RowMask mask{0, 0, 0, type_ == GateType::SWAP || type_ == GateType::CSWAP};
+    for (const auto &[num, is_direct]: controls_) {
+        mask.controls_mask |= line_bit(num);
+        mask.controls_values |= is_direct ? line_bit(num) : 0;
+    }
+    for (auto num: nests_) {
+        mask.nests_mask |= line_bit(num);
+    }
+    return mask;
+}
+
 void Gate::validate_() const {
     for (auto num: nests_) {
         if (num > dim_ - 1) {
@@ -816,6 +863,75 @@ void Circuit::set_memory(size_t memory_lines_num) {
     memory_ = memory_lines_num;
 }
 
+template<size_t N>
+void Circuit::act_kernel_(const std::vector<KernelGate> &gates, cf_set &vec) noexcept {
+    // truth tables of all lines live on the stack, the word loops have a compile-time length
+    constexpr size_t WORDS = N < 6 ? 1 : size_t(1) << (N - 6);
+    constexpr uint64_t ONES = N < 6 ? (uint64_t(1) << (size_t(1) << N)) - 1 : ~uint64_t(0);
+    std::array<std::array<uint64_t, WORDS>, N> lines{};
+    // SWAP exchanges the rows of the lines instead of the words
+    std::array<size_t, N> rows{};
+    for (size_t i = 0; i < N; i++) {
+        std::copy(vec[i].words_.begin(), vec[i].words_.end(), lines[i].begin());
+        rows[i] = i;
+    }
+
+    std::array<uint64_t, WORDS> signal;
+    for (const auto &g: gates) {
+        auto &nest = lines[rows[g.nest]];
+        switch (g.type) {
+            case GateType::NOT:
+                for (size_t w = 0; w < WORDS; w++) {
+                    nest[w] ^= ONES;
+                }
+                break;
+            case GateType::CNOT:
+            case GateType::kCNOT:
+                signal.fill(ONES);
+                for (size_t i = 0; i < g.controls_number; i++) {
+                    const auto &control = lines[rows[g.controls[i].first]];
+                    const uint64_t polarity = g.controls[i].second ? 0 : ~uint64_t(0);
+                    for (size_t w = 0; w < WORDS; w++) {
+                        signal[w] &= control[w] ^ polarity;
+                    }
+                }
+                for (size_t w = 0; w < WORDS; w++) {
+                    nest[w] ^= signal[w];
+                }
+                break;
+            case GateType::SWAP:
+                std::swap(rows[g.nest], rows[g.other_nest]);
+                break;
+            case GateType::CSWAP: {
+                auto &other = lines[rows[g.other_nest]];
+                const auto &control = lines[rows[g.controls.front().first]];
+                const uint64_t polarity = g.controls.front().second ? 0 : ~uint64_t(0);
+                for (size_t w = 0; w < WORDS; w++) {
+                    auto difference = (nest[w] ^ other[w]) & (control[w] ^ polarity);
+                    nest[w] ^= difference;
+                    other[w] ^= difference;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    for (size_t i = 0; i < N; i++) {
+        std::copy(lines[rows[i]].begin(), lines[rows[i]].end(), vec[i].words_.begin());
+    }
+}
+
+std::vector<Gate::RowMask> Circuit::row_masks_() const {
+    std::vector<Gate::RowMask> masks;
+    masks.reserve(gates_.size());
+    for (const auto &g: gates_) {
+        masks.push_back(g.row_mask_());
+    }
+    return masks;
+}
+
 void Circuit::act(binary_vector &vec) const {
     if (vec.size() != dim_) {
         throw CircuitException("Input vector must have length equals to the Circuit dimension");
@@ -831,18 +947,36 @@ void Circuit::act(binary_vector &vec) const {
 }
 
 void Circuit::act(cf_set &vec) const {
+    PROFILE_SCOPE(Phase::SIMULATION);
     if (vec.size() != dim_) {
         throw CircuitException(
                 "Input coordinate boolean functions vector must have length equals to the Circuit dimension");
     }
-    if (!std::all_of(vec.begin(), vec.end(),
-                     [bf_size = std::pow(2, dim_)](const auto &v) {
-                         return v.size() == bf_size;
-                     })) {
+    if (!std::all_of(vec.begin(), vec.end(), [bf_size = size_t(1) << dim_](const auto &v) {
+        return v.size() == bf_size;
+    })) {
         throw CircuitException("Coordinate boolean functions must have the same dimensions as Circuit");
     }
-    for (const auto &g: gates_) {
-        g.act(vec);
+    if (dim_ <= KERNEL_MAX_DIM) {
+        std::vector<KernelGate> kernel_gates;
+        kernel_gates.reserve(gates_.size());
+        for (const auto &g: gates_) {
+            KernelGate kernel_gate{g.type_, g.nests_.front(), g.nests_.back(), 0, {}};
+            for (const auto &control: g.controls_) {
+                kernel_gate.controls[kernel_gate.controls_number++] = control;
+            }
+            kernel_gates.push_back(kernel_gate);
+        }
+        // dispatch table over the widths 0..KERNEL_MAX_DIM
+        static const auto kernels = []<size_t... N>(std::index_sequence<N...>) {
+            return std::array<void (*)(const std::vector<KernelGate> &, cf_set &) noexcept, sizeof...(N)>{
+                    &act_kernel_<N>...};
+        }(std::make_index_sequence<KERNEL_MAX_DIM + 1>());
+        kernels[dim_](kernel_gates, vec);
+    } else {
+        for (const auto &g: gates_) {
+            g.act_unchecked(vec);
+        }
     }
     if (!memory_) {
         return;
@@ -858,6 +992,59 @@ void Circuit::act(cf_set &vec) const {
     }
 }
 
+uint64_t Circuit::act(uint64_t row) const {
+    act_rows_(std::span<uint64_t>(&row, 1));
+    return row;
+}
+
+void Circuit::act(std::span<uint64_t> rows) const {
+    PROFILE_SCOPE(Phase::SIMULATION);
+    act_rows_(rows);
+}
+
+void Circuit::act_rows_(std::span<uint64_t> rows) const {
+    if (dim_ > 64) {
+        throw CircuitException("Packed rows are limited to 64 lines");
+    }
+    if (dim_ < 64 && std::any_of(rows.begin(), rows.end(), [this](auto row) {
+        return row >> dim_;
+    })) {
+        throw CircuitException("Input row must fit in the Circuit dimension");
+    }
+    const auto masks = row_masks_();
+    // memory lines are the last ones, so their bits are the lowest
+    const uint64_t memory_mask = memory_ ? ~uint64_t(0) >> (64 - memory_) : 0;
+
+    // gate-major over blocks of rows: the block stays in cache and the inner loop is branchless
+    const size_t block_size = 4096;
+    auto process = [&](size_t block) {
+        auto first = rows.begin() + static_cast<std::ptrdiff_t>(block * block_size);
+        auto last = rows.begin() + static_cast<std::ptrdiff_t>(std::min((block + 1) * block_size, rows.size()));
+        for (auto it = first; it != last; it++) {
+            *it &= ~memory_mask;
+        }
+        for (const auto &[controls_mask, controls_values, nests_mask, is_swap]: masks) {
+            for (auto it = first; it != last; it++) {
+                const uint64_t x = *it;
+                const bool fires = ((x & controls_mask) == controls_values) &
+                                   (!is_swap | (std::popcount(x & nests_mask) == 1));
+                *it = x ^ (nests_mask & -uint64_t(fires));
+            }
+        }
+    };
+
+    const size_t blocks_number = (rows.size() + block_size - 1) / block_size;
+    if (blocks_number <= 1 || JobsConfig::instance().get() <= 1) {
+        for (size_t block = 0; block < blocks_number; block++) {
+            process(block);
+        }
+        return;
+    }
+    std::vector<size_t> blocks(blocks_number);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    parallel_for_each(blocks, process);
+}
+
 void Circuit::add(const Gate &g) {
     if (g.dim() != dim_) {
         throw CircuitException("Circuit and Gate must have equal dimensions");
@@ -865,6 +1052,19 @@ void Circuit::add(const Gate &g) {
     gates_.push_back(g);
 }
 
+void Circuit::add(std::vector<Gate> &&gates) {
+    if (std::any_of(gates.begin(), gates.end(), [this](const Gate &g) {
+        return g.dim() != dim_;
+    })) {
+        throw CircuitException("Circuit and Gate must have equal dimensions");
+    }
+    if (gates_.empty()) {
+        gates_ = std::move(gates);
+        return;
+    }
+    gates_.insert(gates_.end(), std::make_move_iterator(gates.begin()), std::make_move_iterator(gates.end()));
+}
+
 void Circuit::insert(const Gate &g, size_t pos) {
     if (g.dim() != dim_) {
         throw CircuitException("Circuit and Gate must have equal dimensions");
@@ -925,6 +1125,7 @@ void Circuit::inject(const Circuit &c) {
 }
 
 void Circuit::reduce() noexcept {
+    PROFILE_SCOPE(Phase::REDUCTION);
     size_t swap_number = 0;
     auto subcircuits_borders = split_circuit_(swap_number);
     if (subcircuits_borders.empty()) {
@@ -948,22 +1149,33 @@ void Circuit::reduce() noexcept {
             if (gates_[i].empty()) {
                 continue;
             }
-            for (size_t j = i + 1; j <= subcircuit_end; j++) {
+            // gates i and j may be merged only if every gate between them commutes with both of them
+            std::vector<size_t> between;
+            for (size_t j = i + 1; j <= subcircuit_end && !gates_[i].empty(); j++) {
                 if (gates_[j].empty()) {
                     continue;
                 }
-                if (gates_[i].rR1_(gates_[j])) {
-                    continue;
-                }
-                if (gates_[i].rR3_(gates_[j])) {
-                    continue;
+                bool is_adjacent = std::all_of(between.begin(), between.end(), [&](size_t k) {
+                    return gates_[k].empty() || gates_[k].is_commutes(gates_[j]);
+                });
+                if (is_adjacent) {
+                    if (gates_[i].rR1_(gates_[j])) {
+                        continue;
+                    }
+                    if (gates_[i].rR3_(gates_[j])) {
+                        continue;
+                    }
+                    if (gates_[i].rR4_(gates_[j])) {
+                        continue;
+                    }
+                    if (gates_[i].rR5_(gates_[j])) {
+                        continue;
+                    }
                 }
-                if (gates_[i].rR4_(gates_[j])) {
-                    continue;
-                }
-                if (gates_[i].rR5_(gates_[j])) {
-                    continue;
+                if (!gates_[i].is_commutes(gates_[j])) {
+                    break;
                 }
+                between.push_back(j);
             }
         }
     }
@@ -1065,6 +1277,7 @@ bool Circuit::operator==(const Circuit &c) const {
 }
 
 Circuit::operator std::string() const {
+    PROFILE_SCOPE(Phase::FORMATTING);
     std::string out = "Lines: " + std::to_string(dim_);
     if (memory_) {
         out += "; " + std::to_string(memory_);
@@ -1123,6 +1336,7 @@ std::vector<std::pair<size_t, size_t>> Circuit::split_circuit_(size_t &swap_numb
 }
 
 void Circuit::by_string_(const std::string &s) {
+    PROFILE_SCOPE(Phase::PARSING);
     if (s.empty()) {
         throw CircuitException("Empty string");
     }
@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <numeric>
+#include <optional>
+
+#include "mitm.hpp"
+
+// keys a worker expands at once
+static const size_t MITM_CHUNK = 1024;
+
+// chunks of every worker between two insertions into the table, the extensions found in between are kept aside
+static const size_t MITM_CHUNKS_PER_ROUND = 16;
+
+// the table grows before it is more than three quarters full
+static const size_t MITM_LOAD_NUMERATOR = 3;
+static const size_t MITM_LOAD_DENOMINATOR = 4;
+
+uint64_t pack_substitution(const Substitution &sub) {
+    if (sub.power() > size_t(1) << MITM_MAX_DIM) {
+        throw SynthException("Unable to pack a substitution of power greater than " +
+                             std::to_string(size_t(1) << MITM_MAX_DIM));
+    }
+    uint64_t packed = 0;
+    for (size_t x = 0; x < sub.power(); x++) {
+        packed |= static_cast<uint64_t>(sub.image(x)) << (4 * x);
+    }
+    return packed;
+}
+
+Substitution unpack_substitution(uint64_t packed, size_t power) {
+    std::vector<size_t> images(power);
+    for (size_t x = 0; x < power; x++) {
+        images[x] = (packed >> (4 * x)) & 0xF;
+    }
+    return Substitution(images);
+}
+
+// the packed substitution followed by the gate
+static uint64_t apply_gate_(uint64_t packed, const std::array<uint8_t, 16> &gate_images, size_t power) noexcept {
+    uint64_t result = 0;
+    for (size_t x = 0; x < power; x++) {
+        result |= static_cast<uint64_t>(gate_images[(packed >> (4 * x)) & 0xF]) << (4 * x);
+    }
+    return result;
+}
+
+PackedSubstitutionTable::PackedSubstitutionTable(size_t capacity) {
+    capacity = std::bit_ceil(std::max<size_t>(capacity, 2));
+    keys_.assign(capacity, EMPTY_KEY);
+    gates_.resize(capacity);
+}
+
+size_t PackedSubstitutionTable::slot_(uint64_t key) const noexcept {
+    // the finalizer of splitmix64, the low bits of a packed substitution are the images of the first points
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key & (keys_.size() - 1);
+}
+
+size_t PackedSubstitutionTable::capacity_for_(size_t size) noexcept {
+    return std::bit_ceil(std::max<size_t>(size * MITM_LOAD_DENOMINATOR / MITM_LOAD_NUMERATOR + 1, 2));
+}
+
+bool PackedSubstitutionTable::insert(uint64_t key, uint8_t gate) {
+    if ((size_ + 1) * MITM_LOAD_DENOMINATOR > keys_.size() * MITM_LOAD_NUMERATOR) {
+        reserve(size_ + 1);
+    }
+    for (auto slot = slot_(key);; slot = (slot + 1) & (keys_.size() - 1)) {
+        if (keys_[slot] == key) {
+            return false;
+        }
+        if (keys_[slot] == EMPTY_KEY) {
+            keys_[slot] = key;
+            gates_[slot] = gate;
+            size_++;
+            return true;
+        }
+    }
+}
+
+const uint8_t *PackedSubstitutionTable::find(uint64_t key) const noexcept {
+    for (auto slot = slot_(key);; slot = (slot + 1) & (keys_.size() - 1)) {
+        if (keys_[slot] == key) {
+            return &gates_[slot];
+        }
+        if (keys_[slot] == EMPTY_KEY) {
+            return nullptr;
+        }
+    }
+}
+
+size_t PackedSubstitutionTable::size() const noexcept {
+    return size_;
+}
+
+size_t PackedSubstitutionTable::bytes() const noexcept {
+    return keys_.size() * (sizeof(uint64_t) + sizeof(uint8_t));
+}
+
+size_t PackedSubstitutionTable::bytes_for(size_t more) const noexcept {
+    return std::max(keys_.size(), capacity_for_(size_ + more)) * (sizeof(uint64_t) + sizeof(uint8_t));
+}
+
+void PackedSubstitutionTable::reserve(size_t size) {
+    auto capacity = capacity_for_(size);
+    if (capacity <= keys_.size()) {
+        return;
+    }
+    auto keys = std::move(keys_);
+    auto gates = std::move(gates_);
+    keys_.assign(capacity, EMPTY_KEY);
+    gates_.resize(capacity);
+    size_ = 0;
+    for (size_t slot = 0; slot < keys.size(); slot++) {
+        if (keys[slot] != EMPTY_KEY) {
+            insert(keys[slot], gates[slot]);
+        }
+    }
+}
+
+Circuit MITM_algorithm(const BinaryMapping &bm, bool reduction) {
+    auto bm_extended = bm.extend();
+    auto c = MITM_algorithm(Substitution(bm_extended), reduction);
+    c.set_memory(bm_extended.inputs_number() - bm.inputs_number());
+    return c;
+}
+
+// a meeting of the searches: the key, the key it was reached from and the gate
+using mitm_meeting = std::tuple<uint64_t, uint64_t, uint8_t>;
+
+Circuit MITM_algorithm(const Substitution &sub, bool reduction) {
+    if (!is_power_of_2(sub.power())) {
+        throw SynthException("Substitution size should be power of 2");
+    }
+    const size_t dim = std::log2(sub.power());
+    if (dim > MITM_MAX_DIM) {
+        throw SynthException("Impossible to apply the MITM algorithm to a substitution of power greater than " +
+                             std::to_string(size_t(1) << MITM_MAX_DIM));
+    }
+    const auto power = sub.power();
+    if (sub.is_identical()) {
+        return Circuit(dim);
+    }
+
+    const auto gates = generate_all_gates(dim);
+    if (gates.size() > std::numeric_limits<uint8_t>::max()) {
+        throw SynthException("Too many gates for the MITM algorithm");
+    }
+    std::vector<std::array<uint8_t, 16>> gates_images(gates.size());
+    for (size_t g = 0; g < gates.size(); g++) {
+        auto gate_sub = gates[g].act();
+        for (size_t x = 0; x < power; x++) {
+            gates_images[g][x] = static_cast<uint8_t>(gate_sub.image(x));
+        }
+    }
+    const auto memory_budget = MITMConfig::instance().memory_budget();
+
+    // gates are involutions: the identity followed by the forward gates is the substitution followed by
+    // the backward ones in reverse, so the circuit is the forward path and then the backward path from its end
+    const std::array<uint64_t, 2> roots = {pack_substitution(Substitution(power)), pack_substitution(sub)};
+    std::array<PackedSubstitutionTable, 2> tables;
+    std::array<std::vector<uint64_t>, 2> frontiers;
+    std::array<size_t, 2> depths{};
+    // new keys per frontier key in the last layer of the side, a bound of the next layer
+    std::array<size_t, 2> growths = {gates.size(), gates.size()};
+    for (size_t side = 0; side < 2; side++) {
+        tables[side].insert(roots[side], 0);
+        frontiers[side].push_back(roots[side]);
+    }
+
+    auto path = [&](size_t side, uint64_t key) {
+        std::vector<size_t> gates_indices;
+        while (key != roots[side]) {
+            const auto gate = *tables[side].find(key);
+            gates_indices.push_back(gate);
+            key = apply_gate_(key, gates_images[gate], power);
+        }
+        return gates_indices;
+    };
+
+    while (!frontiers[0].empty() && !frontiers[1].empty()) {
+        check_stop(depths[0] + depths[1]);
+        const size_t side = frontiers[0].size() <= frontiers[1].size() ? 0 : 1;
+        const auto &frontier = frontiers[side];
+        auto &own = tables[side];
+        const auto &other = tables[1 - side];
+
+        // a layer is stored only while it fits into the budget, otherwise it is only searched for a meeting
+        const auto estimate = frontier.size() * growths[side];
+        auto frontiers_bytes = [&](size_t next) {
+            return (frontiers[0].size() + frontiers[1].size() + next) * sizeof(uint64_t);
+        };
+        bool storing = own.bytes_for(estimate) + other.bytes() + frontiers_bytes(estimate) <= memory_budget;
+        std::vector<uint64_t> next_frontier;
+        if (storing) {
+            own.reserve(own.size() + estimate);
+            next_frontier.reserve(estimate);
+        }
+
+        const auto chunks_number = (frontier.size() + MITM_CHUNK - 1) / MITM_CHUNK;
+        const auto round_chunks = std::max<size_t>(JobsConfig::instance().get(), 1) * MITM_CHUNKS_PER_ROUND;
+        std::optional<mitm_meeting> meeting;
+        PROFILE_SCOPE(Phase::CANDIDATE_SCORING);
+        PROFILE_COUNT(Phase::CANDIDATE_SCORING, frontier.size() * gates.size());
+        for (size_t first_chunk = 0; first_chunk < chunks_number && !meeting; first_chunk += round_chunks) {
+            std::vector<size_t> chunks(std::min(round_chunks, chunks_number - first_chunk));
+            std::iota(chunks.begin(), chunks.end(), 0);
+            std::vector<std::vector<std::pair<uint64_t, uint8_t>>> found(chunks.size());
+            std::vector<std::optional<mitm_meeting>> meetings(chunks.size());
+            // chunks after the first one with a meeting are skipped, so the circuit does not depend on the workers
+            std::atomic<size_t> first_meeting = std::numeric_limits<size_t>::max();
+            parallel_for_each(chunks, [&](size_t chunk) {
+                check_stop();
+                if (chunk > first_meeting.load()) {
+                    return;
+                }
+                const auto begin = (first_chunk + chunk) * MITM_CHUNK;
+                const auto end = std::min(frontier.size(), begin + MITM_CHUNK);
+                for (size_t i = begin; i < end; i++) {
+                    for (size_t g = 0; g < gates.size(); g++) {
+                        auto key = apply_gate_(frontier[i], gates_images[g], power);
+                        if (own.find(key)) {
+                            continue;
+                        }
+                        if (other.find(key)) {
+                            meetings[chunk] = mitm_meeting{key, frontier[i], static_cast<uint8_t>(g)};
+                            for (auto first = first_meeting.load();
+                                 chunk < first && !first_meeting.compare_exchange_weak(first, chunk);) {
+                            }
+                            return;
+                        }
+                        if (storing) {
+                            found[chunk].emplace_back(key, static_cast<uint8_t>(g));
+                        }
+                    }
+                }
+            });
+
+            // every meeting of a layer makes a circuit of the same length
+            for (const auto &chunk_meeting: meetings) {
+                if (chunk_meeting) {
+                    meeting = chunk_meeting;
+                    break;
+                }
+            }
+            if (meeting || !storing) {
+                continue;
+            }
+            size_t found_total = 0;
+            for (const auto &chunk_found: found) {
+                found_total += chunk_found.size();
+            }
+            if (own.bytes_for(found_total) + other.bytes() + frontiers_bytes(next_frontier.size() + found_total) >
+                memory_budget) {
+                storing = false;
+                continue;
+            }
+            for (const auto &chunk_found: found) {
+                for (const auto &[key, gate]: chunk_found) {
+                    if (own.insert(key, gate)) {
+                        next_frontier.push_back(key);
+                    }
+                }
+            }
+        }
+
+        if (meeting) {
+            const auto &[key, parent, gate] = *meeting;
+            std::array<std::vector<size_t>, 2> halves;
+            halves[side] = path(side, parent);
+            halves[side].insert(halves[side].begin(), gate);
+            halves[1 - side] = path(1 - side, key);
+            auto forward = std::move(halves[0]);
+            std::reverse(forward.begin(), forward.end());
+            forward.insert(forward.end(), halves[1].begin(), halves[1].end());
+
+            Circuit c(dim);
+            for (auto g: forward) {
+                c.add(gates[g]);
+            }
+            if (reduction) {
+                c.reduce();
+            }
+            if (!verify(c, sub)) {
+                LOG_DEBUG("Performing synthesis using the MITM algorithm",
+                          "The synthesized circuit produces an incorrect mapping: " + static_cast<std::string>(c));
+                throw SynthException("Unable to synthesize Circuit");
+            }
+            return c;
+        }
+        if (!storing) {
+            throw SynthException("The MITM search exceeded its memory budget");
+        }
+
+        growths[side] = (next_frontier.size() + frontier.size() - 1) / frontier.size();
+        frontiers[side] = std::move(next_frontier);
+        depths[side]++;
+    }
+
+    throw SynthException("Unable to synthesize Circuit");
+}
@@ -0,0 +1,114 @@
+#include <numeric>
+#include <optional>
+
+#include "portfolio.hpp"
+
+void PortfolioConfig::set_algorithms(const std::vector<Algo> &algorithms) {
+    if (algorithms.empty()) {
+        throw SynthException("Portfolio should contain at least one algorithm");
+    }
+    if (std::find(algorithms.begin(), algorithms.end(), Algo::PORTFOLIO) != algorithms.end()) {
+        throw SynthException("Portfolio can not contain itself");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    algorithms_ = algorithms;
+}
+
+std::vector<Algo> PortfolioConfig::algorithms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return algorithms_;
+}
+
+void PortfolioConfig::set_timeout(std::chrono::milliseconds timeout) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    timeout_ = timeout;
+}
+
+std::chrono::milliseconds PortfolioConfig::timeout() const noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timeout_;
+}
+
+void PortfolioConfig::set_metric(circuit_metric metric) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    metric_ = std::move(metric);
+}
+
+circuit_metric PortfolioConfig::metric() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return metric_;
+}
+
+static Circuit PORTFOLIO_algorithm_(const Substitution &sub, bool reduction) {
+    const auto &config = PortfolioConfig::instance();
+    const auto algorithms = config.algorithms();
+    const auto metric = config.metric();
+
+    StopCondition condition(current_stop_condition);
+    if (auto timeout = config.timeout(); timeout.count()) {
+        condition.set_timeout(timeout);
+    }
+    // a reduced circuit may be shorter than its partial one, so only the unreduced ones bound the racers
+    const bool bounded = !reduction && !metric;
+
+    std::mutex mutex;
+    std::optional<Circuit> best;
+    double best_score = 0;
+    size_t best_index = 0;
+    std::string errors;
+
+    std::vector<size_t> order(algorithms.size());
+    std::iota(order.begin(), order.end(), 0);
+    parallel_for_each(order, [&](size_t i) {
+        const auto algo = algorithms[i];
+        StopScope scope(&condition);
+        try {
+            check_stop();
+            auto c = synthesize(sub, algo, reduction);
+            // CA does not verify its circuits itself
+            if (!verify(c, sub)) {
+                throw SynthException("The synthesized circuit produces an incorrect mapping");
+            }
+            auto score = metric ? metric(c) : static_cast<double>(c.complexity());
+            if (bounded) {
+                condition.tighten_bound(c.complexity());
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            // of equal scores the algorithm earlier in the portfolio is kept
+            if (!best || score < best_score || (score == best_score && i < best_index)) {
+                best = std::move(c);
+                best_score = score;
+                best_index = i;
+            }
+        } catch (const std::exception &e) {
+            LOG_DEBUG("Performing synthesis using the portfolio",
+                      algo_name(algo) + " failed: " + static_cast<std::string>(e.what()));
+            std::lock_guard<std::mutex> lock(mutex);
+            errors += (errors.empty() ? "" : "; ") + algo_name(algo) + ": " + e.what();
+        }
+    });
+
+    if (!best) {
+        // nothing finished before the deadline or the cancellation of the caller
+        check_stop(&condition);
+        throw SynthException("Unable to synthesize Circuit by any algorithm of the portfolio: " + errors);
+    }
+    return *best;
+}
+
+Circuit PORTFOLIO_algorithm(const BinaryMapping &bm, bool reduction) {
+    if (bm.is_substitution()) {
+        return PORTFOLIO_algorithm(Substitution(bm), reduction);
+    }
+    auto bm_extended = bm.extend();
+    auto c = PORTFOLIO_algorithm_(Substitution(bm_extended), reduction);
+    c.set_memory(bm_extended.inputs_number() - bm.inputs_number());
+    return c;
+}
+
+Circuit PORTFOLIO_algorithm(const Substitution &sub, bool reduction) {
+    if (!is_power_of_2(sub.power())) {
+        throw SynthException("Substitution size should be power of 2");
+    }
+    return PORTFOLIO_algorithm_(sub, reduction);
+}
@@ -1,7 +1,23 @@
+#include <cstring>
+
+#include "jobs.hpp"
 #include "primitives.hpp"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define QCS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
 
 // Boolean function
+static const size_t WORD_BITS = 64;
+
+// bits of a word whose index has bit s equal to zero, s < 6
+static const uint64_t LOWER_HALVES[] = {
+        0x5555555555555555, 0x3333333333333333, 0x0F0F0F0F0F0F0F0F,
+        0x00FF00FF00FF00FF, 0x0000FFFF0000FFFF, 0x00000000FFFFFFFF,
+};
+
 BooleanFunction::BooleanFunction(size_t n, size_t dim) {
     // create bf x_n in basis {x_0, x_1, ..., x_{n-1}}
     if (!dim) {
@@ -10,17 +26,10 @@ BooleanFunction::BooleanFunction(size_t n, size_t dim) {
     if (n > dim - 1) {
         throw BFException("Invalid number of bf variables");
     }
-    size_t len = 1 << dim;
-    int counter = 0;
-    bool value = false;
-    vec_.reserve(len);
-    for (size_t i = 0; i < len; i++) {
-        if (counter == 1 << (dim - n - 1)) {
-            counter = 0;
-            value = !value;
-        }
-        counter++;
-        vec_.push_back(value);
+    resize_(size_t(1) << dim);
+    // x_n is bit (dim - n - 1) of the value index
+    for (size_t w = 0; w < words_.size(); w++) {
+        words_[w] = variable_word_(dim - n - 1, w);
     }
 }
 
@@ -29,8 +38,10 @@ BooleanFunction::BooleanFunction(bool bit, size_t dim) {
     if (!dim) {
         throw BFException("Invalid BF dimension");
     }
-    for (auto i = 0; i < 1 << dim; i++) {
-        vec_.push_back(bit);
+    resize_(size_t(1) << dim);
+    if (bit) {
+        std::fill(words_.begin(), words_.end(), ~uint64_t(0));
+        clear_tail_();
     }
 }
 
@@ -38,20 +49,22 @@ BooleanFunction::BooleanFunction(const binary_vector &v) {
     if (v.size() == 1 || !is_power_of_2(v.size())) {
         throw BFException("Invalid BF vector length");
     }
-    vec_ = v;
+    resize_(v.size());
+    for (size_t i = 0; i < v.size(); i++) {
+        set_bit_(i, v[i]);
+    }
 }
 
 BooleanFunction::BooleanFunction(const std::vector<int> &v) {
     if (v.size() == 1 || !is_power_of_2(v.size())) {
         throw BFException("Invalid BF vector length");
     }
-    for (auto i: v) {
-        if (i == 1) {
-            vec_.push_back(true);
-        } else if (!i) {
-            vec_.push_back(false);
-        } else {
-            throw BFException("Unexpected value if BF vector: " + std::to_string(i));
+    resize_(v.size());
+    for (size_t i = 0; i < v.size(); i++) {
+        if (v[i] == 1) {
+            set_bit_(i, true);
+        } else if (v[i]) {
+            throw BFException("Unexpected value if BF vector: " + std::to_string(v[i]));
         }
     }
 }
@@ -60,31 +73,31 @@ BooleanFunction::BooleanFunction(const std::string &s) {
     if (s.size() == 1 || !is_power_of_2(s.size())) {
         throw BFException("Invalid BF vector length");
     }
-    for (auto i: s) {
-        if (i == '1') {
-            vec_.push_back(true);
-        } else if (i == '0') {
-            vec_.push_back(false);
-        } else {
-            throw BFException("Unexpected value if BF vector: " + std::to_string(i));
+    resize_(s.size());
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '1') {
+            set_bit_(i, true);
+        } else if (s[i] != '0') {
+            throw BFException("Unexpected value if BF vector: " + std::to_string(s[i]));
         }
     }
 }
 
 BooleanFunction::BooleanFunction(const BooleanFunction &bf) {
-    vec_ = bf.vec_;
+    size_ = bf.size_;
+    words_ = bf.words_;
 }
 
 BooleanFunction &BooleanFunction::operator=(const BooleanFunction &bf) {
-    if (this->operator!=(bf)) {
-        vec_.clear();
-        vec_ = bf.vec_;
+    if (this != &bf) {
+        size_ = bf.size_;
+        words_ = bf.words_;
     }
     return *this;
 }
 
 bool BooleanFunction::operator==(const BooleanFunction &bf) const {
-    return vec_ == bf.vec_;
+    return size_ == bf.size_ && words_ == bf.words_;
 }
 
 bool BooleanFunction::operator!=(const BooleanFunction &bf) const {
@@ -95,8 +108,8 @@ BooleanFunction &BooleanFunction::operator+=(const BooleanFunction &bf) {
     if (this->dim() != bf.dim()) {
         throw BFException("Boolean functions must have the same dimensions");
     }
-    for (size_t i = 0; i < vec_.size(); i++) {
-        vec_[i] = vec_[i] != bf.vec_[i];
+    for (size_t w = 0; w < words_.size(); w++) {
+        words_[w] ^= bf.words_[w];
     }
     return *this;
 }
@@ -105,8 +118,8 @@ BooleanFunction &BooleanFunction::operator*=(const BooleanFunction &bf) {
     if (this->dim() != bf.dim()) {
         throw BFException("Boolean functions must have the same dimensions");
     }
-    for (size_t i = 0; i < vec_.size(); i++) {
-        vec_[i] = vec_[i] && bf.vec_[i];
+    for (size_t w = 0; w < words_.size(); w++) {
+        words_[w] &= bf.words_[w];
     }
     return *this;
 }
@@ -115,16 +128,17 @@ BooleanFunction &BooleanFunction::operator|=(const BooleanFunction &bf) {
     if (this->dim() != bf.dim()) {
         throw BFException("Boolean functions must have the same dimensions");
     }
-    for (size_t i = 0; i < vec_.size(); i++) {
-        vec_[i] = vec_[i] || bf.vec_[i];
+    for (size_t w = 0; w < words_.size(); w++) {
+        words_[w] |= bf.words_[w];
     }
     return *this;
 }
 
 BooleanFunction &BooleanFunction::operator~() noexcept {
-    for (auto &&bit: vec_) {
-        bit = !bit;
+    for (auto &word: words_) {
+        word = ~word;
     }
+    clear_tail_();
     return *this;
 }
 
@@ -132,11 +146,11 @@ BooleanFunction::operator bool() const {
     if (!this->is_constant()) {
         throw BFException("Unable to cast BF into bool");
     }
-    return vec_.front();
+    return bit_(0);
 }
 
 size_t BooleanFunction::size() const noexcept {
-    return vec_.size();
+    return size_;
 }
 
 size_t BooleanFunction::dim() const noexcept {
@@ -144,7 +158,11 @@ size_t BooleanFunction::dim() const noexcept {
 }
 
 size_t BooleanFunction::weight() const noexcept {
-    return std::accumulate(vec_.begin(), vec_.end(), 0);
+    size_t weight = 0;
+    for (auto word: words_) {
+        weight += std::popcount(word);
+    }
+    return weight;
 }
 
 bool BooleanFunction::is_balanced() const noexcept {
@@ -152,43 +170,91 @@ bool BooleanFunction::is_balanced() const noexcept {
 }
 
 bool BooleanFunction::is_constant() const noexcept {
-    return !bool(std::count_if(vec_.cbegin(), vec_.cend(), [bit = vec_.front()](bool b) {
-        return bit != b;
-    }));
+    auto weight = this->weight();
+    return !weight || weight == this->size();
 }
 
 size_t BooleanFunction::variable() const {
-    for (size_t i = 0; i < this->dim(); i++) {
-        if (this->operator==(BooleanFunction(i, this->dim()))) {
-            return i;
+    // a projection is recognized by a few words: x_n is bit s = dim - n - 1 of the value index
+    if (words_.empty() || this->dim() < 1) {
+        throw BFException("BF is not variable");
+    }
+    size_t s = this->dim();
+    for (size_t low = 0; low < std::min<size_t>(this->dim(), 6); low++) {
+        if (words_.front() == variable_word_(low, 0)) {
+            s = low;
+            break;
+        }
+    }
+    if (s == this->dim() && !words_.front()) {
+        for (size_t high = 6; high < this->dim(); high++) {
+            if (words_[size_t(1) << (high - 6)]) {
+                s = high;
+                break;
+            }
         }
     }
+    if (s < this->dim() && this->is_variable(this->dim() - s - 1)) {
+        return this->dim() - s - 1;
+    }
     throw BFException("BF is not variable");
 }
 
-std::vector<bool> BooleanFunction::mobius_transformation() const noexcept {
-    std::vector<bool> anf(vec_);
-
-    for (size_t s = 0; s < this->dim(); s++) {
-        const size_t mask = 1 << s;
-        for (size_t i = 0; i < vec_.size(); i++) {
-            if (i & mask) {
-                anf[i] = anf[i] ^ anf[i ^ mask];
+bool BooleanFunction::is_variable(size_t n, bool inverted) const noexcept {
+    if (n >= this->dim()) {
+        return false;
+    }
+    size_t s = this->dim() - n - 1;
+    auto expected = [&](size_t w) {
+        auto word = variable_word_(s, w);
+        if (inverted) {
+            word = ~word;
+            if (w == words_.size() - 1 && size_ % WORD_BITS) {
+                word &= (uint64_t(1) << (size_ % WORD_BITS)) - 1;
             }
         }
+        return word;
+    };
+    // the first and the last words differ for every projection, so they reject most functions at once
+    if (words_.front() != expected(0) || words_.back() != expected(words_.size() - 1)) {
+        return false;
+    }
+    for (size_t w = 1; w + 1 < words_.size(); w++) {
+        if (words_[w] != expected(w)) {
+            return false;
+        }
     }
+    return true;
+}
 
+std::vector<bool> BooleanFunction::mobius_transformation() const noexcept {
+    auto anf_words = mobius_words_();
+    std::vector<bool> anf(size_);
+    for (size_t i = 0; i < size_; i++) {
+        anf[i] = (anf_words[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+    }
     return anf;
 }
 
+std::vector<size_t> BooleanFunction::monomials() const noexcept {
+    auto anf_words = mobius_words_();
+    std::vector<size_t> result;
+    for (size_t w = 0; w < anf_words.size(); w++) {
+        for (auto word = anf_words[w]; word; word &= word - 1) {
+            result.push_back(w * WORD_BITS + std::countr_zero(word));
+        }
+    }
+    return result;
+}
+
 std::vector<int> BooleanFunction::RW_spectrum() const noexcept {
     std::vector<int> spectrum;
-    spectrum.reserve(vec_.size());
+    spectrum.reserve(size_);
 
-    for (size_t u = 0; u < vec_.size(); u++) {
+    for (size_t u = 0; u < size_; u++) {
         int sum = 0;
-        for (size_t x = 0; x < vec_.size(); x++) {
-            sum += vec_[x] * static_cast<int>(std::pow(-1, binary_dot(u, x)));
+        for (size_t x = 0; x < size_; x++) {
+            sum += bit_(x) * static_cast<int>(std::pow(-1, binary_dot(u, x)));
         }
         spectrum.push_back(sum);
     }
@@ -224,56 +290,120 @@ BinaryMapping BooleanFunction::extend() const {
     // the values of the original function will be achieved by feeding zeros to additional inputs
     // if f(x1,...,xn) make f1(x1,...,x{n+1})=f+x{n+1}
     // f1(x1,...,xn,0)=f
-    binary_vector bf_values;
-    size_t height;
-    std::string truth_table_s;
-    size_t width = this->dim();
-    if (!this->is_balanced()) {
-        height = (1 << (this->dim() + 1)) - 1;
-        width += 1;
-        for (auto bit: vec_) {
-            bf_values.push_back(bit);
-            bf_values.push_back(!bit);
+    // a row with the value v is mapped to the next free output ending with v
+    const bool balanced = this->is_balanced();
+    const size_t width = balanced ? this->dim() : this->dim() + 1;
+    const size_t rows = size_t(1) << width;
+
+    cf_set cf;
+    cf.reserve(width);
+    for (size_t i = 0; i < width; i++) {
+        cf.emplace_back(false, width);
+    }
+    std::array<size_t, 2> ranks{0, 0};
+    for (size_t r = 0; r < rows; r++) {
+        const bool value = balanced ? bit_(r) : bit_(r / 2) ^ (r & 1);
+        const size_t image = (ranks[value]++ << 1) | value;
+        for (size_t i = 0; i < width; i++) {
+            if ((image >> (width - i - 1)) & 1) {
+                cf[i].set_bit_(r, true);
+            }
         }
-    } else {
-        height = (1 << this->dim()) - 1;
-        bf_values = vec_;
     }
+    return BinaryMapping(cf);
+}
 
-    size_t even = height;
-    size_t odd = height - 1;
-    for (auto bit: bf_values) {
-        if (bit) {
-            truth_table_s += decimal_to_binary_s(height - odd, width) + '\n';
-            odd -= 2;
-            continue;
-        }
-        truth_table_s += decimal_to_binary_s(height - even, width) + '\n';
-        even -= 2;
+binary_vector BooleanFunction::vector() const noexcept {
+    binary_vector v(size_);
+    for (size_t i = 0; i < size_; i++) {
+        v[i] = bit_(i);
     }
-    return BinaryMapping(truth_table_s);
+    return v;
 }
 
-binary_vector BooleanFunction::vector() const noexcept {
-    return vec_;
+bool BooleanFunction::value(size_t i) const {
+    if (i >= size_) {
+        throw BFException("Argument out of the BF domain: " + std::to_string(i));
+    }
+    return bit_(i);
 }
 
 std::string BooleanFunction::to_table(char sep) const noexcept {
     std::string out;
     std::string set;
     for (size_t i = 0; i < this->size(); i++) {
-        out += decimal_to_binary_s(i, this->dim()) + sep + (vec_[i] ? '1' : '0') + '\n';
+        out += decimal_to_binary_s(i, this->dim()) + sep + (bit_(i) ? '1' : '0') + '\n';
     }
     return out;
 }
 
 std::ostream &operator<<(std::ostream &out, const BooleanFunction &bf) noexcept {
-    for (auto v: bf.vec_) {
-        out << (v ? '1' : '0');
+    for (size_t i = 0; i < bf.size_; i++) {
+        out << (bf.bit_(i) ? '1' : '0');
     }
     return out;
 }
 
+bool BooleanFunction::bit_(size_t i) const noexcept {
+    return (words_[i / WORD_BITS] >> (i % WORD_BITS)) & 1;
+}
+
+void BooleanFunction::set_bit_(size_t i, bool value) noexcept {
+    auto mask = uint64_t(1) << (i % WORD_BITS);
+    if (value) {
+        words_[i / WORD_BITS] |= mask;
+    } else {
+        words_[i / WORD_BITS] &= ~mask;
+    }
+}
+
+void BooleanFunction::resize_(size_t size) {
+    size_ = size;
+    words_.assign((size + WORD_BITS - 1) / WORD_BITS, 0);
+}
+
+void BooleanFunction::clear_tail_() noexcept {
+    if (size_ % WORD_BITS) {
+        words_.back() &= (uint64_t(1) << (size_ % WORD_BITS)) - 1;
+    }
+}
+
+uint64_t BooleanFunction::variable_word_(size_t s, size_t w) const noexcept {
+    // word w of the function equal to bit s of the value index
+    uint64_t word;
+    if (s < 6) {
+        word = ~LOWER_HALVES[s];
+    } else {
+        word = (w >> (s - 6)) & 1 ? ~uint64_t(0) : 0;
+    }
+    if (w == words_.size() - 1 && size_ % WORD_BITS) {
+        word &= (uint64_t(1) << (size_ % WORD_BITS)) - 1;
+    }
+    return word;
+}
+
+std::vector<uint64_t> BooleanFunction::mobius_words_() const noexcept {
+    auto anf = words_;
+    auto dim = this->dim();
+
+    // stages of the low 6 variables stay inside a word: the lower half of every block is added to the upper one
+    for (size_t s = 0; s < std::min<size_t>(dim, 6); s++) {
+        for (auto &word: anf) {
+            word ^= (word & LOWER_HALVES[s]) << (size_t(1) << s);
+        }
+    }
+    // the higher stages add whole words
+    for (size_t s = 6; s < dim; s++) {
+        const size_t step = size_t(1) << (s - 6);
+        for (size_t w = 0; w < anf.size(); w++) {
+            if (w & step) {
+                anf[w] ^= anf[w ^ step];
+            }
+        }
+    }
+    return anf;
+}
+
 BooleanFunction operator+(const BooleanFunction &bf1, const BooleanFunction &bf2) {
     BooleanFunction bf3(bf1);
     bf3 += bf2;
@@ -341,13 +471,14 @@ BinaryMapping::BinaryMapping(const Substitution &sub) {
         throw BMException("Impossible to transform Substitution into BM whose power is not power of 2");
     }
     size_t cols = std::log2(sub.power());
+    const auto images = sub.vector();
     table truth_table(cols, binary_vector(sub.power(), false));
     for (size_t col = 0; col < cols; col++) {
         size_t bit_pos = cols - col - 1;
-        size_t mask = 1u << bit_pos;
+        size_t mask = size_t(1) << bit_pos;
         auto &cf_col = truth_table[col];
         for (size_t row = 0; row < sub.power(); row++) {
-            cf_col[row] = sub.vector()[row] & mask;
+            cf_col[row] = images[row] & mask;
         }
     }
     cf_.reserve(cols);
@@ -410,35 +541,120 @@ bool BinaryMapping::is_substitution() const noexcept {
     }
 }
 
-BinaryMapping BinaryMapping::extend() const {
+uint64_t BinaryMapping::row(size_t x) const {
+    if (cf_.size() > 64) {
+        throw BMException("Packed rows are limited to 64 outputs");
+    }
+    uint64_t out = 0;
+    for (const auto &bf: cf_) {
+        out = (out << 1) | bf.value(x);
+    }
+    return out;
+}
+
+BinaryMapping BinaryMapping::extend(Embedding embedding) const {
     // extends the mapping to a reversible mapping
+    if (embedding == Embedding::MINIMAL_GARBAGE) {
+        return this->is_substitution() ? *this : minimal_extend_();
+    }
+
     if (cf_.size() == 1) {
-        return BooleanFunction(cf_.front()).extend();
+        return cf_.front().extend();
     }
 
     if (this->is_substitution()) {
         return *this;
     }
 
-    int inputs = cf_.front().dim();
-    int outputs = cf_.size();
-    table truth_table;
+    // x_1..x_n, y_1..y_m -> x_1..x_n, y_1+f_1(x),...,y_m+f_m(x), the packed words are built directly
+    const size_t inputs = this->inputs_number();
+    const size_t outputs = this->outputs_number();
+    const size_t dim = inputs + outputs;
+
+    cf_set cf;
+    cf.reserve(dim);
+    for (size_t i = 0; i < inputs; i++) {
+        cf.emplace_back(i, dim);
+    }
+    for (size_t k = 0; k < outputs; k++) {
+        const auto &f = cf_[k];
+        auto &column = cf.emplace_back(false, dim);
+        for (size_t w = 0; w < column.words_.size(); w++) {
+            // the row r of the word takes the value f(r >> outputs)
+            uint64_t spread = 0;
+            if (outputs >= 6) {
+                spread = f.bit_(w >> (outputs - 6)) ? ~uint64_t(0) : 0;
+            } else {
+                const size_t repeat = size_t(1) << outputs;
+                const size_t first = (w * WORD_BITS) >> outputs;
+                for (size_t j = 0; j < WORD_BITS / repeat && first + j < f.size(); j++) {
+                    if (f.bit_(first + j)) {
+                        spread |= ((uint64_t(1) << repeat) - 1) << (j * repeat);
+                    }
+                }
+            }
+            column.words_[w] = spread ^ column.variable_word_(outputs - k - 1, w);
+        }
+        column.clear_tail_();
+    }
+    return BinaryMapping(cf);
+}
+
+BinaryMapping BinaryMapping::minimal_extend_() const {
+    // an input x with zero garbage is mapped to (r, f(x)), where r counts the preceding inputs with the same output,
+    // so ceil(log2(max multiplicity)) garbage lines keep the outputs distinct
+    const size_t inputs = this->inputs_number();
+    const size_t outputs = this->outputs_number();
+    std::vector<uint64_t> values(size_t(1) << inputs);
+    for (size_t x = 0; x < values.size(); x++) {
+        values[x] = this->row(x);
+    }
+
+    size_t max_multiplicity = 0;
+    std::vector<size_t> ranks(values.size());
+    auto count = [&](auto &counters) {
+        for (size_t x = 0; x < values.size(); x++) {
+            ranks[x] = counters[values[x]]++;
+            max_multiplicity = std::max(max_multiplicity, ranks[x] + 1);
+        }
+    };
+    // a dense counter for every output value unless there are more of them than inputs
+    if (outputs <= inputs) {
+        std::vector<size_t> counters(size_t(1) << outputs);
+        count(counters);
+    } else {
+        std::unordered_map<uint64_t, size_t> counters;
+        count(counters);
+    }
 
-    for (int i = inputs + outputs - 1; i >= 0; i--) {
-        auto column_bf = BooleanFunction(static_cast<size_t>(i), outputs + inputs);
-        if (i - inputs < 0) {
-            truth_table.insert(truth_table.begin(), column_bf.vector());
+    const size_t garbage = std::bit_width(max_multiplicity - 1);
+    const size_t dim = std::max(inputs, outputs + garbage);
+    if (dim >= 64) {
+        throw BMException("Too many lines for the reversible embedding");
+    }
+
+    // inputs are the upper lines, so the rows with nonzero additional lines take the free images in order
+    const size_t shift = dim - inputs;
+    std::vector<size_t> images(size_t(1) << dim);
+    std::vector<bool> used(images.size());
+    for (size_t x = 0; x < values.size(); x++) {
+        const size_t image = (ranks[x] << outputs) | values[x];
+        images[x << shift] = image;
+        used[image] = true;
+    }
+    const size_t additional_mask = (size_t(1) << shift) - 1;
+    size_t free_image = 0;
+    for (size_t r = 0; r < images.size(); r++) {
+        if (!(r & additional_mask)) {
             continue;
         }
-        binary_vector extension;
-        for (auto bit: cf_[i - inputs].vector()) {
-            for (auto _ = 0; _ < 1 << outputs; _++) {
-                extension.push_back(bit);
-            }
+        while (used[free_image]) {
+            free_image++;
         }
-        truth_table.insert(truth_table.begin(), (BooleanFunction(extension) + column_bf).vector());
+        images[r] = free_image;
+        used[free_image] = true;
     }
-    return BinaryMapping(truth_table);
+    return BinaryMapping(Substitution(images));
 }
 
 table BinaryMapping::to_table_() const noexcept {
@@ -450,6 +666,7 @@ table BinaryMapping::to_table_() const noexcept {
 }
 
 void BinaryMapping::by_string_(const std::string &s) {
+    PROFILE_SCOPE(Phase::PARSING);
     if (s.empty()) {
         throw BMException("Empty truth table");
     }
@@ -496,6 +713,7 @@ void BinaryMapping::by_string_(const std::string &s) {
 }
 
 std::string BinaryMapping::to_table(char sep) const noexcept {
+    PROFILE_SCOPE(Phase::FORMATTING);
     auto truth_table = this->to_table_();
     std::string result;
     for (size_t i = 0; i < truth_table.front().size(); i++) {
@@ -536,8 +754,175 @@ bool is_substitution(const std::vector<size_t> &vec) {
     return checked.size() == vec.size();
 }
 
+// compositions and inversions of at least that many points are split into chunks between JobsConfig workers
+static const size_t SUBSTITUTION_PARALLEL_POWER = size_t(1) << 16;
+
+static const size_t SUBSTITUTION_CHUNK = size_t(1) << 14;
+
+template<typename Kernel>
+static void for_each_chunk_(size_t size, Kernel kernel) {
+    if (size < SUBSTITUTION_PARALLEL_POWER || inside_parallel_task || JobsConfig::instance().get() < 2) {
+        kernel(0, size);
+        return;
+    }
+    std::vector<size_t> chunks((size + SUBSTITUTION_CHUNK - 1) / SUBSTITUTION_CHUNK);
+    std::iota(chunks.begin(), chunks.end(), 0);
+    parallel_for_each(chunks, [&kernel, size](size_t chunk) {
+        kernel(chunk * SUBSTITUTION_CHUNK, std::min(size, (chunk + 1) * SUBSTITUTION_CHUNK));
+    });
+}
+
+// images[i] = other[images[i]]
+template<typename T>
+static void compose_range_(T *images, const T *other, size_t begin, size_t end) noexcept {
+    for (size_t i = begin; i < end; i++) {
+        images[i] = other[images[i]];
+    }
+}
+
+// inverse[images[i]] = i
+template<typename T>
+static void invert_range_(const T *images, T *inverse, size_t begin, size_t end) noexcept {
+    for (size_t i = begin; i < end; i++) {
+        inverse[images[i]] = static_cast<T>(i);
+    }
+}
+
+#ifdef QCS_X86_KERNELS
+
+static bool has_ssse3_() noexcept {
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+    return supported;
+}
+
+static bool has_avx2_() noexcept {
+    static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return supported;
+}
+
+// up to 16 points of a byte are composed by a single shuffle
+__attribute__((target("ssse3")))
+static void compose_ssse3_(uint8_t *images, const uint8_t *other, size_t size) noexcept {
+    alignas(16) std::array<uint8_t, 16> indices{};
+    alignas(16) std::array<uint8_t, 16> lookup{};
+    std::memcpy(indices.data(), images, size);
+    std::memcpy(lookup.data(), other, size);
+    auto result = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(lookup.data())),
+                                   _mm_load_si128(reinterpret_cast<const __m128i *>(indices.data())));
+    _mm_store_si128(reinterpret_cast<__m128i *>(indices.data()), result);
+    std::memcpy(images, indices.data(), size);
+}
+
+// 8 images at once, the indices of the gather are signed so the points are below 2^31
+__attribute__((target("avx2")))
+static void compose_avx2_(uint32_t *images, const uint32_t *other, size_t begin, size_t end) noexcept {
+    const auto *lookup = reinterpret_cast<const int *>(other);
+    auto i = begin;
+    for (; i + 8 <= end; i += 8) {
+        auto indices = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(images + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(images + i), _mm256_i32gather_epi32(lookup, indices, 4));
+    }
+    compose_range_(images, other, i, end);
+}
+
+// 8 images of two bytes at once: a lane gathers the 4 bytes at its image and keeps the low half. The 4 bytes of
+// the last point end beyond the lookup, so its lanes are masked out and take its image from the source operand
+__attribute__((target("avx2")))
+static void compose_avx2_(uint16_t *images, const uint16_t *other, size_t begin, size_t end, size_t size) noexcept {
+    const auto *lookup = reinterpret_cast<const int *>(other);
+    const auto last = _mm256_set1_epi32(static_cast<int>(size - 1));
+    const auto last_image = _mm256_set1_epi32(other[size - 1]);
+    const auto low_half = _mm256_set1_epi32(0xFFFF);
+    const auto all = _mm256_set1_epi32(-1);
+    auto i = begin;
+    for (; i + 8 <= end; i += 8) {
+        auto indices = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(images + i)));
+        auto inside = _mm256_xor_si256(_mm256_cmpeq_epi32(indices, last), all);
+        auto gathered = _mm256_and_si256(_mm256_mask_i32gather_epi32(last_image, lookup, indices, inside, 2), low_half);
+        // the pack works within 128-bit halves, the first and the third quadwords are the 8 images in order
+        auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(gathered, gathered), 0b1000);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(images + i), _mm256_castsi256_si128(packed));
+    }
+    compose_range_(images, other, i, end);
+}
+
+#endif
+
+template<typename T>
+static void compose_(std::vector<T> &images, const std::vector<T> &other) {
+    const auto size = images.size();
+#ifdef QCS_X86_KERNELS
+    if constexpr (std::is_same_v<T, uint8_t>) {
+        if (size <= 16 && has_ssse3_()) {
+            compose_ssse3_(images.data(), other.data(), size);
+            return;
+        }
+    }
+    if constexpr (std::is_same_v<T, uint16_t>) {
+        if (has_avx2_()) {
+            for_each_chunk_(size, [&images, &other, size](size_t begin, size_t end) {
+                compose_avx2_(images.data(), other.data(), begin, end, size);
+            });
+            return;
+        }
+    }
+    if constexpr (std::is_same_v<T, uint32_t>) {
+        if (size <= size_t(1) << 31 && has_avx2_()) {
+            for_each_chunk_(size, [&images, &other](size_t begin, size_t end) {
+                compose_avx2_(images.data(), other.data(), begin, end);
+            });
+            return;
+        }
+    }
+#endif
+    for_each_chunk_(size, [&images, &other](size_t begin, size_t end) {
+        compose_range_(images.data(), other.data(), begin, end);
+    });
+}
+
+template<typename T>
+static void invert_(const std::vector<T> &images, std::vector<T> &inverse) {
+    inverse.resize(images.size());
+    for_each_chunk_(images.size(), [&images, &inverse](size_t begin, size_t end) {
+        invert_range_(images.data(), inverse.data(), begin, end);
+    });
+}
+
+// the number of cycles of the substitution x -> next(x), the marks are kept by the thread between the calls
+template<typename Next>
+static size_t count_cycles_(size_t size, Next next) {
+    thread_local std::vector<uint8_t> visited;
+    visited.assign(size, 0);
+    size_t cycles = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (visited[i]) {
+            continue;
+        }
+        cycles++;
+        for (auto x = i; !visited[x]; x = next(x)) {
+            visited[x] = 1;
+        }
+    }
+    return cycles;
+}
+
+// the number of points minus the number of cycles of h^-1 * g, the inverse is kept by the thread between the calls
+template<typename T>
+static size_t cayley_distance_(const std::vector<T> &g, const std::vector<T> &h) {
+    thread_local std::vector<T> inverse;
+    invert_(h, inverse);
+    return g.size() - count_cycles_(g.size(), [&g](size_t x) {
+        return g[inverse[x]];
+    });
+}
+
 size_t cayley_distance(const Substitution &sub1, const Substitution &sub2) {
     // sub1 = g; sub2 = h
+    if (sub1.power() == sub2.power()) {
+        return std::visit([&sub2](const auto &g) {
+            return cayley_distance_(g, std::get<std::decay_t<decltype(g)>>(sub2.sub_));
+        }, sub1.sub_);
+    }
     int n = std::max(sub1.power(), sub2.power());
     auto hg = sub2.invert() * sub1;
     return n - hg.cycles().size();
@@ -547,11 +932,10 @@ Substitution::Substitution(const std::vector<size_t> &v) {
     if (v.empty()) {
         throw SubException("Empty coordinate function set");
     }
-    sub_ = v;
-    if (!is_substitution(sub_)) {
-        sub_.clear();
+    if (!is_substitution(v)) {
         throw SubException("Unable to build substitution");
     }
+    assign_(v);
 }
 
 Substitution::Substitution(const std::vector<cycle_type> &cycles) {
@@ -573,14 +957,10 @@ Substitution::Substitution(const std::vector<transposition_type> &transpositions
 
     *this = Substitution(power + 1);
     for (const auto &[i, j]: transpositions) {
-        auto temp_sub = Substitution(power + 1);
-        std::swap(temp_sub.sub_[i], temp_sub.sub_[j]);
-        *this = temp_sub * *this;
-    }
-
-    if (!is_substitution(sub_)) {
-        sub_.clear();
-        throw SubException("Unable to build substitution");
+        std::vector<size_t> images(power + 1);
+        std::iota(images.begin(), images.end(), 0);
+        std::swap(images[i], images[j]);
+        *this = Substitution(images) * *this;
     }
 }
 
@@ -606,18 +986,18 @@ Substitution::Substitution(const cf_set &cf) {
                    [](const auto &bf) {
                        return bf.vector();
                    });
-    sub_ = std::vector<size_t>(bf_size);
+    std::vector<size_t> images(bf_size);
     for (size_t i = 0; i < bf_size; i++) {
         std::string line;
         for (const auto &v: truth_table) {
             line += v[i] ? '1' : '0';
         }
-        sub_[i] = binary_to_decimal(line);
+        images[i] = binary_to_decimal(line);
     }
-    if (!is_substitution(sub_)) {
-        sub_.clear();
+    if (!is_substitution(images)) {
         throw SubException("Unable to build substitution");
     }
+    assign_(images);
 }
 
 Substitution::Substitution(const table &t) {
@@ -635,18 +1015,18 @@ Substitution::Substitution(const table &t) {
     if (static_cast<size_t>(std::log2(col_size)) != t.size()) {
         throw SubException("Coordinate boolean functions form an irreversible mapping");
     }
-    sub_ = std::vector<size_t>(col_size);
+    std::vector<size_t> images(col_size);
     for (size_t i = 0; i < col_size; i++) {
         std::string line;
         for (const auto &v: t) {
             line += v[i] ? '1' : '0';
         }
-        sub_.push_back(binary_to_decimal(line));
+        images.push_back(binary_to_decimal(line));
     }
-    if (!is_substitution(sub_)) {
-        sub_.clear();
+    if (!is_substitution(images)) {
         throw SubException("Unable to build substitution");
     }
+    assign_(images);
 }
 
 Substitution::Substitution(const std::string &s) {
@@ -657,9 +1037,9 @@ Substitution::Substitution(const size_t power) {
     if (power < 2) {
         throw SubException("Substitution power should be greater than 1");
     }
-    for (size_t i = 0; i < power; i++) {
-        sub_.push_back(i);
-    }
+    std::vector<size_t> images(power);
+    std::iota(images.begin(), images.end(), 0);
+    assign_(images);
 }
 
 Substitution::Substitution(std::istream &s) {
@@ -678,7 +1058,6 @@ Substitution::Substitution(const BinaryMapping &mp) {
 
 Substitution &Substitution::operator=(const Substitution &sub) {
     if (this->operator!=(sub)) {
-        sub_.clear();
         sub_ = sub.sub_;
     }
     return *this;
@@ -687,13 +1066,13 @@ Substitution &Substitution::operator=(const Substitution &sub) {
 Substitution &Substitution::operator=(const BinaryMapping &mp) {
     Substitution sub(mp);
     if (this->operator!=(sub)) {
-        sub_.clear();
-        sub_ = sub.sub_;
+        sub_ = std::move(sub.sub_);
     }
     return *this;
 }
 
 bool Substitution::operator==(const Substitution &sub) const {
+    // substitutions of the same power hold the same type, the vectors of bytes are compared by memcmp
     return sub_ == sub.sub_;
 }
 
@@ -714,40 +1093,102 @@ bool Substitution::operator!=(const BinaryMapping &bm) const {
 }
 
 Substitution &Substitution::operator*=(const Substitution &s) {
+    if (this == &s) {
+        return *this *= Substitution(s);
+    }
+    if (power() == s.power()) {
+        // the images of the same type are composed in place
+        std::visit([&s](auto &images) {
+            compose_(images, std::get<std::decay_t<decltype(images)>>(s.sub_));
+        }, sub_);
+        return *this;
+    }
+
+    auto own = vector();
+    auto other = s.vector();
     std::vector<size_t> images(std::max(s.power(), power()));
 
     for (size_t i = 0; i < images.size(); i++) {
-        if (i < sub_.size()) {
-            auto image = sub_[i];
-            if (image >= s.sub_.size()) {
+        if (i < own.size()) {
+            auto image = own[i];
+            if (image >= other.size()) {
                 images[i] = image;
                 continue;
             }
-            images[i] = s.sub_[image];
+            images[i] = other[image];
             continue;
         }
-        images[i] = s.sub_[i];
+        images[i] = other[i];
     }
 
-    sub_ = images;
+    assign_(images);
     return *this;
 }
 
 size_t Substitution::power() const noexcept {
-    return sub_.size();
+    return std::visit([](const auto &images) {
+        return images.size();
+    }, sub_);
 }
 
+// bytes i of the word are i + 8 * word
+static const std::array<uint64_t, 2> IDENTITY_BYTES = {0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull};
+
 bool Substitution::is_identical() const noexcept {
-    for (size_t i = 0; i < sub_.size(); i++) {
-        if (sub_[i] != i) {
-            return false;
+    // up to 16 points are compared by two words
+    if (const auto *bytes = std::get_if<std::vector<uint8_t>>(&sub_); bytes && bytes->size() <= 16) {
+        const auto size = bytes->size();
+        std::array<uint64_t, 2> words{};
+        std::memcpy(words.data(), bytes->data(), size);
+        const auto low_mask = size >= 8 ? ~uint64_t(0) : (uint64_t(1) << (8 * size)) - 1;
+        const auto high_mask = size >= 16 ? ~uint64_t(0) : size <= 8 ? 0 : (uint64_t(1) << (8 * (size - 8))) - 1;
+        return words[0] == (IDENTITY_BYTES[0] & low_mask) && words[1] == (IDENTITY_BYTES[1] & high_mask);
+    }
+    return std::visit([](const auto &images) {
+        for (size_t i = 0; i < images.size(); i++) {
+            if (images[i] != i) {
+                return false;
+            }
         }
-    }
-    return true;
+        return true;
+    }, sub_);
 }
 
 std::vector<size_t> Substitution::vector() const noexcept {
-    return sub_;
+    return std::visit([](const auto &images) {
+        return std::vector<size_t>(images.begin(), images.end());
+    }, sub_);
+}
+
+ExtensionView::ExtensionView(const BinaryMapping &bm) : bm_(bm) {
+    if (bm.inputs_number() + bm.outputs_number() > 64) {
+        throw BMException("Packed rows are limited to 64 lines");
+    }
+}
+
+size_t ExtensionView::inputs_number() const noexcept {
+    return bm_.inputs_number() + bm_.outputs_number();
+}
+
+size_t ExtensionView::outputs_number() const noexcept {
+    return bm_.inputs_number() + bm_.outputs_number();
+}
+
+uint64_t ExtensionView::row(size_t x) const {
+    const auto outputs = bm_.outputs_number();
+    if (this->inputs_number() < 64 && x >> this->inputs_number()) {
+        throw BMException("Row out of the mapping domain: " + std::to_string(x));
+    }
+    return x ^ bm_.row(x >> outputs);
+}
+
+size_t Substitution::image(size_t x) const {
+    if (x >= power()) {
+        throw SubException("Element out of the Substitution domain: " + std::to_string(x));
+    }
+    return std::visit([x](const auto &images) -> size_t {
+        return images[x];
+    }, sub_);
 }
 
 std::vector<transposition_type> Substitution::transpositions() const noexcept {
@@ -767,7 +1208,8 @@ std::vector<cycle_type> Substitution::cycles() const noexcept {
     std::unordered_set<size_t> visited;
     std::vector<cycle_type> cycles;
 
-    for (size_t i = 0; i < sub_.size(); i++) {
+    const auto images = vector();
+    for (size_t i = 0; i < images.size(); i++) {
         if (visited.count(i)) {
             continue;
         }
@@ -777,32 +1219,63 @@ std::vector<cycle_type> Substitution::cycles() const noexcept {
         while (!visited.count(element)) {
             visited.insert(element);
             cycle.push_back(element);
-            element = sub_[element];
+            element = images[element];
         }
         cycles.push_back(cycle);
     }
     return cycles;
 }
 
-Substitution Substitution::invert() const noexcept {
-    std::vector<size_t> images(sub_.size());
-    for (size_t i = 0; i < sub_.size(); i++) {
-        images[sub_[i]] = i;
-    }
-    return Substitution(images);
+size_t Substitution::cycles_number() const {
+    return std::visit([](const auto &images) {
+        return count_cycles_(images.size(), [&images](size_t x) {
+            return images[x];
+        });
+    }, sub_);
+}
+
+Substitution Substitution::invert() const {
+    auto inverse = *this;
+    std::visit([this](auto &inverse_images) {
+        invert_(std::get<std::decay_t<decltype(inverse_images)>>(sub_), inverse_images);
+    }, inverse.sub_);
+    return inverse;
+}
+
+Substitution &Substitution::invert_in_place() {
+    std::visit([](auto &images) {
+        thread_local std::decay_t<decltype(images)> scratch;
+        invert_(images, scratch);
+        images.swap(scratch);
+    }, sub_);
+    return *this;
 }
 
 bool Substitution::is_odd() const noexcept {
     return transpositions().size() % 2;
 }
 
+void Substitution::assign_(const std::vector<size_t> &images) {
+    if (images.size() <= size_t(1) << 8) {
+        sub_ = std::vector<uint8_t>(images.begin(), images.end());
+    } else if (images.size() <= size_t(1) << 16) {
+        sub_ = std::vector<uint16_t>(images.begin(), images.end());
+    } else if (images.size() <= size_t(1) << 32) {
+        sub_ = std::vector<uint32_t>(images.begin(), images.end());
+    } else {
+        throw SubException("Unable to handle substitution of power greater than 2^32");
+    }
+}
+
 void Substitution::by_string_(const std::string &s) {
+    PROFILE_SCOPE(Phase::PARSING);
     if (s.empty()) {
         throw SubException("Empty substitution");
     }
     std::stringstream ss(s);
     std::string line;
     std::string value;
+    std::vector<size_t> images;
 
     while (getline(ss, line, '\n')) {
         trim(line);
@@ -815,13 +1288,13 @@ void Substitution::by_string_(const std::string &s) {
             if (!try_string_to_decimal(value, value_int)) {
                 throw SubException("Invalid value: " + value);
             }
-            sub_.push_back(value_int);
+            images.push_back(value_int);
         }
     }
-    if (!is_substitution(sub_)) {
-        sub_.clear();
+    if (!is_substitution(images)) {
         throw SubException("Unable to build substitution");
     }
+    assign_(images);
 }
 
 Substitution substitution_by_cycle(const cycle_type &cycle) {
@@ -832,14 +1305,12 @@ Substitution substitution_by_cycle(const cycle_type &cycle) {
     if (!power) {
         return Substitution(2);
     }
-    Substitution sub(power + 1);
-    if (cycle.size() == 1) {
-        return sub;
-    }
-    for (size_t i = 0; i < cycle.size() - 1; i++) {
-        std::swap(sub.sub_[cycle[i]], sub.sub_[cycle[i + 1]]);
+    std::vector<size_t> images(power + 1);
+    std::iota(images.begin(), images.end(), 0);
+    for (size_t i = 0; i + 1 < cycle.size(); i++) {
+        std::swap(images[cycle[i]], images[cycle[i + 1]]);
     }
-    return sub;
+    return Substitution(images);
 }
 
 // TODO well yeah that sucks
@@ -848,16 +1319,37 @@ Substitution substitution_power_of_2_by_cycle(const cycle_type &cycle) {
     if (is_power_of_2(sub.power())) {
         return sub;
     }
+    auto images = sub.vector();
     for (size_t i = sub.power(); i < std::bit_ceil(sub.power()); i++) {
-        sub.sub_.push_back(i);
+        images.push_back(i);
     }
-    return sub;
+    return Substitution(images);
 }
 
-std::ostream &operator<<(std::ostream &out, const Substitution &sub) noexcept {
-    for (size_t i = 0; i < sub.power(); i++) {
-        out << sub.sub_[i] << ' ';
+size_t substitution_rank(const Substitution &sub) {
+    if (sub.power() > 20) {
+        throw SubException("Unable to rank substitution of power greater than 20");
     }
+    return permutation_rank(sub.vector());
+}
+
+Substitution substitution_by_rank(size_t rank, size_t power) {
+    if (power < 2) {
+        throw SubException("Substitution power should be greater than 1");
+    }
+    if (power > 20 || rank >= factorial(power)) {
+        throw SubException("Substitution rank out of range");
+    }
+    return Substitution(permutation_by_rank(rank, power));
+}
+
+std::ostream &operator<<(std::ostream &out, const Substitution &sub) noexcept {
+    PROFILE_SCOPE(Phase::FORMATTING);
+    std::visit([&out](const auto &images) {
+        for (auto image: images) {
+            out << static_cast<size_t>(image) << ' ';
+        }
+    }, sub.sub_);
     return out;
 }
 
@@ -866,3 +1358,48 @@ Substitution operator*(const Substitution &sub1, const Substitution &sub2) {
     sub3 *= sub2;
     return sub3;
 }
+
+#if defined(__SIZEOF_INT128__)
+__extension__ using uint128_ = unsigned __int128;
+#endif
+
+// the high and the low words of the product xor-ed
+static uint64_t wymix_(uint64_t a, uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+    auto product = static_cast<uint128_>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+    const uint64_t a_low = a & 0xffffffff, a_high = a >> 32, b_low = b & 0xffffffff, b_high = b >> 32;
+    const auto middle = a_high * b_low + (a_low * b_low >> 32);
+    const auto low = a * b;
+    const auto high = a_high * b_high + (middle >> 32) + ((a_low * b_high + (middle & 0xffffffff)) >> 32);
+    return low ^ high;
+#endif
+}
+
+// the primes of wyhash
+static const uint64_t WY_P0 = 0xa0761d6478bd642full;
+static const uint64_t WY_P1 = 0xe7037ed1a0b428dbull;
+
+static uint64_t read_word_(const unsigned char *bytes, size_t size) noexcept {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes, size);
+    return word;
+}
+
+size_t std::hash<Substitution>::operator()(const Substitution &sub) const noexcept {
+    return std::visit([](const auto &images) -> size_t {
+        const auto *bytes = reinterpret_cast<const unsigned char *>(images.data());
+        const size_t size = images.size() * sizeof(typename std::decay_t<decltype(images)>::value_type);
+        uint64_t seed = WY_P0 ^ size;
+        size_t i = 0;
+        for (; size - i > 16; i += 16) {
+            seed = wymix_(read_word_(bytes + i, 8) ^ WY_P1, read_word_(bytes + i + 8, 8) ^ seed);
+        }
+        // the last 1 to 16 bytes
+        const auto rest = size - i;
+        const auto a = read_word_(bytes + i, std::min<size_t>(rest, 8));
+        const auto b = rest > 8 ? read_word_(bytes + i + 8, rest - 8) : 0;
+        return wymix_(WY_P1 ^ size, wymix_(a ^ WY_P1, b ^ seed));
+    }, sub.sub_);
+}
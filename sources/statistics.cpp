@@ -0,0 +1,295 @@
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+
+#include "statistics.hpp"
+
+void RunningStatistics::add(double value) noexcept {
+    count_++;
+    if (count_ == 1) {
+        min_ = max_ = value;
+    } else {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+    auto delta = value - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (value - mean_);
+}
+
+void RunningStatistics::merge(const RunningStatistics &other) noexcept {
+    if (!other.count_) {
+        return;
+    }
+    if (!count_) {
+        *this = other;
+        return;
+    }
+    auto count = count_ + other.count_;
+    auto delta = other.mean_ - mean_;
+    auto weight = static_cast<double>(other.count_) / static_cast<double>(count);
+    mean_ += delta * weight;
+    m2_ += other.m2_ + delta * delta * static_cast<double>(count_) * weight;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    count_ = count;
+}
+
+size_t RunningStatistics::count() const noexcept {
+    return count_;
+}
+
+double RunningStatistics::mean() const noexcept {
+    return mean_;
+}
+
+double RunningStatistics::variance() const noexcept {
+    return count_ > 1 ? m2_ / static_cast<double>(count_) : 0;
+}
+
+double RunningStatistics::min() const noexcept {
+    return min_;
+}
+
+double RunningStatistics::max() const noexcept {
+    return max_;
+}
+
+std::ostream &operator<<(std::ostream &out, const RunningStatistics &statistics) {
+    auto precision = out.precision(std::numeric_limits<double>::max_digits10);
+    out << statistics.count_ << ' ' << statistics.mean_ << ' ' << statistics.m2_ << ' ' << statistics.min_ << ' '
+        << statistics.max_;
+    out.precision(precision);
+    return out;
+}
+
+std::istream &operator>>(std::istream &in, RunningStatistics &statistics) {
+    return in >> statistics.count_ >> statistics.mean_ >> statistics.m2_ >> statistics.min_ >> statistics.max_;
+}
+
+void SynthesisStatistics::add(const Circuit &c, double microseconds) {
+    lines_.add(static_cast<double>(c.dim()));
+    memory_.add(static_cast<double>(c.memory()));
+    gates_.add(static_cast<double>(c.complexity()));
+    microseconds_.add(microseconds);
+    gates_histogram_[c.complexity()]++;
+}
+
+void SynthesisStatistics::add_failure() noexcept {
+    failed_++;
+}
+
+void SynthesisStatistics::merge(const SynthesisStatistics &other) {
+    failed_ += other.failed_;
+    lines_.merge(other.lines_);
+    memory_.merge(other.memory_);
+    gates_.merge(other.gates_);
+    microseconds_.merge(other.microseconds_);
+    for (const auto &[gates, count]: other.gates_histogram_) {
+        gates_histogram_[gates] += count;
+    }
+}
+
+size_t SynthesisStatistics::processed() const noexcept {
+    return gates_.count() + failed_;
+}
+
+size_t SynthesisStatistics::failed() const noexcept {
+    return failed_;
+}
+
+const RunningStatistics &SynthesisStatistics::lines() const noexcept {
+    return lines_;
+}
+
+const RunningStatistics &SynthesisStatistics::memory() const noexcept {
+    return memory_;
+}
+
+const RunningStatistics &SynthesisStatistics::gates() const noexcept {
+    return gates_;
+}
+
+const RunningStatistics &SynthesisStatistics::microseconds() const noexcept {
+    return microseconds_;
+}
+
+const std::map<size_t, size_t> &SynthesisStatistics::gates_histogram() const noexcept {
+    return gates_histogram_;
+}
+
+std::string SynthesisStatistics::to_json() const {
+    auto running_json = [](const RunningStatistics &statistics) {
+        std::stringstream ss;
+        ss << "{\"mean\": " << statistics.mean() << ", \"variance\": " << statistics.variance() << ", \"min\": "
+           << statistics.min() << ", \"max\": " << statistics.max() << '}';
+        return ss.str();
+    };
+
+    std::stringstream ss;
+    ss << "{\n"
+       << "  \"processed\": " << processed() << ",\n"
+       << "  \"failed\": " << failed_ << ",\n"
+       << "  \"lines\": " << running_json(lines_) << ",\n"
+       << "  \"memory\": " << running_json(memory_) << ",\n"
+       << "  \"gates\": " << running_json(gates_) << ",\n"
+       << "  \"microseconds\": " << running_json(microseconds_) << ",\n"
+       << "  \"gates_histogram\": {";
+    for (auto it = gates_histogram_.begin(); it != gates_histogram_.end(); it++) {
+        ss << (it == gates_histogram_.begin() ? "" : ", ") << '"' << it->first << "\": " << it->second;
+    }
+    ss << "}\n}\n";
+    return ss.str();
+}
+
+std::ostream &operator<<(std::ostream &out, const SynthesisStatistics &statistics) {
+    out << statistics.failed_ << '\n' << statistics.lines_ << '\n' << statistics.memory_ << '\n' << statistics.gates_
+        << '\n' << statistics.microseconds_ << '\n' << statistics.gates_histogram_.size();
+    for (const auto &[gates, count]: statistics.gates_histogram_) {
+        out << ' ' << gates << ' ' << count;
+    }
+    return out << '\n';
+}
+
+std::istream &operator>>(std::istream &in, SynthesisStatistics &statistics) {
+    size_t histogram_size = 0;
+    in >> statistics.failed_ >> statistics.lines_ >> statistics.memory_ >> statistics.gates_ >>
+       statistics.microseconds_ >> histogram_size;
+    statistics.gates_histogram_.clear();
+    for (size_t i = 0; i < histogram_size && in; i++) {
+        size_t gates = 0;
+        size_t count = 0;
+        in >> gates >> count;
+        statistics.gates_histogram_[gates] = count;
+    }
+    return in;
+}
+
+static const std::string CHECKPOINT_HEADER = "# statistics";
+
+// a checkpoint is resumed only by the run it was written by
+struct StatisticsRun {
+    Algo algo;
+    size_t dim;
+    size_t total;
+    uint64_t seed;
+    bool reduction;
+
+    bool operator==(const StatisticsRun &) const = default;
+};
+
+static void save_checkpoint_(const std::string &path, const StatisticsRun &run, size_t next,
+                             const SynthesisStatistics &statistics) {
+    // the previous checkpoint is replaced only by a completely written one
+    auto temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary);
+        file << CHECKPOINT_HEADER << '\n' << static_cast<int>(run.algo) << ' ' << run.dim << ' ' << run.total << ' '
+             << run.seed << ' ' << run.reduction << ' ' << next << '\n' << statistics;
+        if (!file) {
+            throw IOException("Unable to write statistics checkpoint: " + temporary);
+        }
+    }
+    std::filesystem::rename(temporary, path);
+}
+
+// the index the run continues from, zero without a checkpoint
+static size_t load_checkpoint_(const std::string &path, const StatisticsRun &run, SynthesisStatistics &statistics) {
+    std::ifstream file(path);
+    if (!file) {
+        return 0;
+    }
+    std::string header;
+    std::getline(file, header);
+    int algo = 0;
+    StatisticsRun saved{};
+    size_t next = 0;
+    file >> algo >> saved.dim >> saved.total >> saved.seed >> saved.reduction >> next >> statistics;
+    saved.algo = static_cast<Algo>(algo);
+    if (!file || header != CHECKPOINT_HEADER || next > run.total) {
+        throw IOException("Invalid statistics checkpoint: " + path);
+    }
+    if (!(saved == run)) {
+        throw IOException("Statistics checkpoint belongs to another run: " + path);
+    }
+    return next;
+}
+
+static void synthesize_into_(SynthesisStatistics &statistics, const std::vector<size_t> &images, Algo algo,
+                             bool reduction) {
+    auto start = std::chrono::steady_clock::now();
+    try {
+        auto c = synthesize(Substitution(images), algo, reduction);
+        auto end = std::chrono::steady_clock::now();
+        statistics.add(c, std::chrono::duration<double, std::micro>(end - start).count());
+    } catch (const std::exception &) {
+        statistics.add_failure();
+    }
+}
+
+// process(first, last, statistics) handles the indices [first, last) of the run; chunks of a round are taken
+// by the workers, the round is merged and saved before the next one starts
+template<typename Process>
+static SynthesisStatistics collect_(const StatisticsRun &run, const std::string &checkpoint, Process process) {
+    SynthesisStatistics statistics;
+    size_t next = checkpoint.empty() ? 0 : load_checkpoint_(checkpoint, run, statistics);
+    const size_t round_size = std::max<size_t>(JobsConfig::instance().get(), 1) * STATISTICS_CHUNKS_PER_ROUND *
+                              STATISTICS_CHUNK;
+
+    std::mutex mutex;
+    while (next < run.total) {
+        const size_t round_end = std::min(run.total, next + round_size);
+        std::vector<size_t> chunks;
+        for (size_t first = next; first < round_end; first += STATISTICS_CHUNK) {
+            chunks.push_back(first / STATISTICS_CHUNK);
+        }
+        parallel_for_each(chunks, [&](size_t chunk) {
+            SynthesisStatistics chunk_statistics;
+            const size_t first = chunk * STATISTICS_CHUNK;
+            process(first, std::min(run.total, first + STATISTICS_CHUNK), chunk_statistics);
+            std::lock_guard<std::mutex> lock(mutex);
+            statistics.merge(chunk_statistics);
+        });
+        next = round_end;
+        if (!checkpoint.empty()) {
+            save_checkpoint_(checkpoint, run, next, statistics);
+        }
+    }
+    return statistics;
+}
+
+SynthesisStatistics exhaustive_statistics(Algo algo, size_t dim, bool reduction, const std::string &checkpoint) {
+    if (!dim || dim > EXHAUSTIVE_MAX_DIM) {
+        throw SynthException("Exhaustive statistics are collected for 1 to " + std::to_string(EXHAUSTIVE_MAX_DIM) +
+                             " lines, use sampled statistics for more lines");
+    }
+    const size_t power = size_t(1) << dim;
+    const StatisticsRun run{algo, dim, factorial(power), 0, reduction};
+    return collect_(run, checkpoint, [&](size_t first, size_t last, SynthesisStatistics &statistics) {
+        // the ranks of a chunk are consecutive in the order of std::next_permutation
+        auto images = permutation_by_rank<size_t>(first, power);
+        for (size_t rank = first; rank < last; rank++) {
+            synthesize_into_(statistics, images, algo, reduction);
+            std::next_permutation(images.begin(), images.end());
+        }
+    });
+}
+
+SynthesisStatistics sampled_statistics(Algo algo, size_t dim, size_t samples, uint64_t seed, bool reduction,
+                                       const std::string &checkpoint) {
+    if (!dim || dim >= std::numeric_limits<size_t>::digits) {
+        throw SynthException("Invalid dimension of sampled substitutions: " + std::to_string(dim));
+    }
+    const size_t power = size_t(1) << dim;
+    const StatisticsRun run{algo, dim, samples, seed, reduction};
+    return collect_(run, checkpoint, [&](size_t first, size_t last, SynthesisStatistics &statistics) {
+        std::mt19937_64 generator(seed + first / STATISTICS_CHUNK);
+        std::vector<size_t> images(power);
+        for (size_t i = first; i < last; i++) {
+            std::iota(images.begin(), images.end(), 0);
+            std::shuffle(images.begin(), images.end(), generator);
+            synthesize_into_(statistics, images, algo, reduction);
+        }
+    });
+}
@@ -1,7 +1,12 @@
+#include "autotune.hpp"
+#include "database.hpp"
+#include "mitm.hpp"
+#include "portfolio.hpp"
 #include "synthesis.hpp"
 
 
 Circuit synthesize(const BinaryMapping &bm, Algo algo, bool reduction) {
+    PROFILE_SCOPE(Phase::SYNTHESIS);
     if (algo == Algo::DUMMY) {
         return dummy_algorithm(bm, reduction);
     }
@@ -17,10 +22,36 @@ Circuit synthesize(const BinaryMapping &bm, Algo algo, bool reduction) {
     if (algo == Algo::CA) {
         return CA_algorithm(bm, reduction);
     }
+    if (algo == Algo::OPT) {
+        return OPT_algorithm(bm, reduction);
+    }
+    if (algo == Algo::AUTO) {
+        return AUTO_algorithm(bm, reduction);
+    }
+    if (algo == Algo::PORTFOLIO) {
+        return PORTFOLIO_algorithm(bm, reduction);
+    }
+    if (algo == Algo::GS_BEAM) {
+        return GS_beam_algorithm(bm, BeamConfig::instance().get(), reduction);
+    }
+    if (algo == Algo::MITM) {
+        return MITM_algorithm(bm, reduction);
+    }
     throw SynthException("Unknown synthesis algorithm");
 }
 
+Circuit synthesize(const BinaryMapping &bm, Algo algo, bool reduction, Embedding embedding) {
+    if (algo == Algo::DUMMY || embedding == Embedding::BENNETT) {
+        return synthesize(bm, algo, reduction);
+    }
+    auto bm_extended = bm.extend(embedding);
+    auto c = synthesize(Substitution(bm_extended), algo, reduction);
+    c.set_memory(bm_extended.inputs_number() - bm.inputs_number());
+    return c;
+}
+
 Circuit synthesize(const Substitution &sub, Algo algo, bool reduction) {
+    PROFILE_SCOPE(Phase::SYNTHESIS);
     if (algo == Algo::DUMMY) {
         return dummy_algorithm(sub, reduction);
     }
@@ -36,9 +67,76 @@ Circuit synthesize(const Substitution &sub, Algo algo, bool reduction) {
     if (algo == Algo::CA) {
         return CA_algorithm(sub, reduction);
     }
+    if (algo == Algo::OPT) {
+        return OPT_algorithm(sub, reduction);
+    }
+    if (algo == Algo::AUTO) {
+        return AUTO_algorithm(sub, reduction);
+    }
+    if (algo == Algo::PORTFOLIO) {
+        return PORTFOLIO_algorithm(sub, reduction);
+    }
+    if (algo == Algo::GS_BEAM) {
+        return GS_beam_algorithm(sub, BeamConfig::instance().get(), reduction);
+    }
+    if (algo == Algo::MITM) {
+        return MITM_algorithm(sub, reduction);
+    }
     throw SynthException("Unknown synthesis algorithm");
 }
 
+Circuit synthesize(const BinaryMapping &bm, Algo algo, bool reduction, const StopCondition &condition) {
+    StopScope scope(&condition);
+    return synthesize(bm, algo, reduction);
+}
+
+Circuit synthesize(const Substitution &sub, Algo algo, bool reduction, const StopCondition &condition) {
+    StopScope scope(&condition);
+    return synthesize(sub, algo, reduction);
+}
+
+void check_stop(const StopCondition *condition, size_t gates) {
+    if (!condition) {
+        return;
+    }
+    auto reason = condition->reason(gates);
+    if (reason == StopReason::DEADLINE) {
+        throw TimeoutException();
+    }
+    if (reason != StopReason::NONE) {
+        throw CancelledException("Synthesis was cancelled");
+    }
+}
+
+void check_stop(size_t gates) {
+    check_stop(current_stop_condition, gates);
+}
+
+void check_stop(const Circuit &partial) {
+    try {
+        check_stop(partial.complexity());
+    } catch (const TimeoutException &) {
+        throw TimeoutException(partial);
+    }
+}
+
+std::string algo_name(Algo algo) {
+    static const std::map<Algo, std::string> names = {
+            {Algo::DUMMY,     "dummy"},
+            {Algo::RW,        "rw"},
+            {Algo::GS,        "gs"},
+            {Algo::ZKB,       "zkb"},
+            {Algo::CA,        "ca"},
+            {Algo::OPT,       "opt"},
+            {Algo::AUTO,      "auto"},
+            {Algo::PORTFOLIO, "portfolio"},
+            {Algo::GS_BEAM,   "beam"},
+            {Algo::MITM,      "mitm"},
+    };
+    auto it = names.find(algo);
+    return it == names.end() ? "unknown" : it->second;
+}
+
 Circuit dummy_algorithm(const BinaryMapping &bm, bool reduction) {
     const auto bm_bf = bm.coordinate_functions();
 
@@ -47,43 +145,40 @@ Circuit dummy_algorithm(const BinaryMapping &bm, bool reduction) {
     auto c = Circuit(c_dim);
     c.set_memory(outputs);
 
-    std::vector<std::future<std::vector<Gate>>> futures;
-    auto process_range = [&](size_t start, size_t end) -> std::vector<Gate> {
-        std::vector<Gate> gates;
-        for (size_t i = start; i < end; i++) {
-            auto anf = bm_bf[i].mobius_transformation();
+    std::vector<size_t> order(outputs);
+    std::iota(order.begin(), order.end(), 0);
 
-            if (anf.front()) {
-                gates.emplace_back(GateType::NOT, std::vector<size_t>{bm.inputs_number() + i}, controls_type{}, c_dim);
-            }
+    // the transform costs the same for every output, so it also estimates the gates work
+    std::vector<std::vector<size_t>> monomials(outputs);
+    parallel_for_each(order, [&](size_t i) {
+        check_stop();
+        monomials[i] = bm_bf[i].monomials();
+    });
 
-            for (size_t c_set = 1; c_set < anf.size(); c_set++) {
-                if (anf[c_set]) {
-                    controls_type controls;
-                    for (const auto num: bits_mask(c_set, bm.inputs_number())) {
-                        controls[num] = true;
-                    }
-                    gates.emplace_back(GateType::kCNOT, std::vector<size_t>{bm.inputs_number() + i}, controls, c_dim);
-                }
+    // outputs with the most monomials are taken first
+    std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+        return monomials[i].size() > monomials[j].size();
+    });
+
+    std::vector<std::vector<Gate>> gates(outputs);
+    parallel_for_each(order, [&](size_t i) {
+        gates[i].reserve(monomials[i].size());
+        for (auto monomial: monomials[i]) {
+            if (!monomial) {
+                gates[i].emplace_back(GateType::NOT, std::vector<size_t>{bm.inputs_number() + i}, controls_type{},
+                                      c_dim);
+                continue;
+            }
+            controls_type controls;
+            for (; monomial; monomial &= monomial - 1) {
+                controls.emplace(bm.inputs_number() - std::countr_zero(monomial) - 1, true);
             }
+            gates[i].emplace_back(GateType::kCNOT, std::vector<size_t>{bm.inputs_number() + i}, controls, c_dim);
         }
-        return gates;
-    };
-
-    size_t num_threads = JobsConfig::instance().get();
-    size_t batch_size = (outputs + num_threads - 1) / num_threads;
+    });
 
-    for (size_t i = 0; i < outputs; i += batch_size) {
-        size_t start = i;
-        size_t end = std::min(i + batch_size, outputs);
-        futures.push_back(std::async(std::launch::async, process_range, start, end));
-    }
-
-    for (auto &future: futures) {
-        auto gates = future.get();
-        for (const auto &gate: gates) {
-            c.add(gate);
-        }
+    for (auto &output_gates: gates) {
+        c.add(std::move(output_gates));
     }
 
     if (reduction) {
@@ -99,6 +194,70 @@ Circuit dummy_algorithm(const Substitution &sub, bool reduction) {
     return dummy_algorithm(BinaryMapping(sub), reduction);
 }
 
+static bool is_sampled_(const Circuit &c, size_t inputs) {
+    return VerificationConfig::instance().get() == Verification::SAMPLED && c.dim() <= 64 && inputs < 64 &&
+           (uint64_t(1) << inputs) > VerificationConfig::instance().samples();
+}
+
+template<typename Image>
+static bool verify_sampled_(const Circuit &c, size_t inputs, Image image) {
+    const auto samples = VerificationConfig::instance().samples();
+    std::mt19937_64 generator(std::random_device{}());
+    std::uniform_int_distribution<uint64_t> distribution(0, (uint64_t(1) << inputs) - 1);
+
+    // memory lines are the last ones, so the inputs are the highest bits of a row
+    std::vector<uint64_t> xs(samples);
+    std::vector<uint64_t> rows(samples);
+    for (size_t k = 0; k < samples; k++) {
+        xs[k] = distribution(generator);
+        rows[k] = xs[k] << c.memory();
+    }
+    c.act(std::span<uint64_t>(rows));
+    for (size_t k = 0; k < samples; k++) {
+        if (rows[k] != image(xs[k])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool verify(const Circuit &c, const BinaryMapping &bm) {
+    PROFILE_SCOPE(Phase::VERIFICATION);
+    if (VerificationConfig::instance().get() == Verification::NONE) {
+        return true;
+    }
+    const auto inputs = bm.inputs_number();
+    if (inputs != c.dim() - c.memory() || bm.outputs_number() != c.dim()) {
+        return false;
+    }
+    if (is_sampled_(c, inputs)) {
+        return verify_sampled_(c, inputs, [&bm](size_t x) {
+            return bm.row(x);
+        });
+    }
+    return c.produce_mapping() == bm;
+}
+
+bool verify(const Circuit &c, const Substitution &sub) {
+    PROFILE_SCOPE(Phase::VERIFICATION);
+    if (VerificationConfig::instance().get() == Verification::NONE) {
+        return true;
+    }
+    if (!is_power_of_2(sub.power())) {
+        return false;
+    }
+    const size_t inputs = std::log2(sub.power());
+    if (inputs != c.dim() - c.memory()) {
+        return false;
+    }
+    if (is_sampled_(c, inputs)) {
+        return verify_sampled_(c, inputs, [&sub](size_t x) {
+            return sub.image(x);
+        });
+    }
+    return c.produce_mapping() == sub;
+}
+
 size_t count_gates(GateType type, size_t dim, bool on_nest) noexcept {
     size_t number = 0;
     if (type == GateType::NOT) {
@@ -263,6 +422,7 @@ std::vector<Gate> generate_gates_by_type(GateType type, size_t max_controls, siz
 }
 
 std::vector<Gate> generate_all_gates(const std::vector<GateType> &types, size_t dim) {
+    PROFILE_SCOPE(Phase::GATE_GENERATION);
     if (!dim) {
         throw SynthException("Dimension value should be at least 1");
     }
@@ -306,6 +466,7 @@ std::vector<Gate> generate_all_gates(size_t dim) {
 
 std::vector<Gate> generate_all_gates(const std::vector<GateType> &types, size_t nest,
                                      size_t max_controls, size_t dim) {
+    PROFILE_SCOPE(Phase::GATE_GENERATION);
     if (!dim) {
         throw SynthException("Gates dimension value should be at least 1");
     }
@@ -356,13 +517,14 @@ Circuit RW_algorithm(const BinaryMapping &bm, bool reduction) {
     }
 
     while (true) {
+        check_stop(c);
         if (c.produce_mapping() == bm_extend) {
             c.set_memory(bm_extend.inputs_number() - bm.inputs_number());
             return c;
         }
 
         for (size_t nest = 0; nest < outputs; nest++) {
-            if (bm_cf[nest] == ~BooleanFunction(nest, outputs)) {
+            if (bm_cf[nest].is_variable(nest, true)) {
                 auto g = Gate(GateType::NOT, {nest}, {}, outputs);
                 c.insert(g, 0);
                 g.act(bm_cf);
@@ -373,7 +535,7 @@ Circuit RW_algorithm(const BinaryMapping &bm, bool reduction) {
 
         for (size_t gate_type_idx = 0; gate_type_idx < 3 && !gate_chosen; gate_type_idx++) {
             for (size_t nest = 0; nest < outputs && !gate_chosen; nest++) {
-                if (bm_cf[nest] == BooleanFunction(nest, outputs)) {
+                if (bm_cf[nest].is_variable(nest)) {
                     continue;
                 }
 
@@ -381,14 +543,16 @@ Circuit RW_algorithm(const BinaryMapping &bm, bool reduction) {
                 auto max_complexity_diff = 0;
                 Gate best_gate;
 
+                PROFILE_SCOPE(Phase::CANDIDATE_SCORING);
+                PROFILE_COUNT(Phase::CANDIDATE_SCORING, precomputed_gates[gate_type_idx][nest].size());
                 for (const auto &gate: precomputed_gates[gate_type_idx][nest]) {
-                    gate.act(bm_cf);
+                    gate.act_unchecked(bm_cf);
                     auto complexity_new = bm_cf[nest].complexity();
                     if (complexity_new - complexity >= max_complexity_diff) {
                         max_complexity_diff = complexity_new - complexity;
                         best_gate = gate;
                     }
-                    gate.act(bm_cf);
+                    gate.act_unchecked(bm_cf);
                 }
 
                 if (max_complexity_diff) {
@@ -413,9 +577,14 @@ Circuit RW_algorithm(const BinaryMapping &bm, bool reduction) {
     }
 
     try {
+        std::vector<size_t> variables;
+        for (const auto &bf: bm_cf) {
+            variables.push_back(bf.variable());
+        }
         for (size_t i = 0; i < outputs; i++) {
             for (size_t j = i + 1; j < outputs; j++) {
-                if (bm_cf[i].variable() > bm_cf[j].variable()) {
+                if (variables[i] > variables[j]) {
+                    std::swap(variables[i], variables[j]);
                     std::swap(bm_cf[i], bm_cf[j]);
                     c.insert(Gate(GateType::SWAP, {i, j}, {}, outputs), 0);
                 }
@@ -431,7 +600,7 @@ Circuit RW_algorithm(const BinaryMapping &bm, bool reduction) {
         c.reduce();
     }
 
-    if (c.produce_mapping() != bm_extend) {
+    if (!verify(c, bm_extend)) {
         LOG_DEBUG("Performing synthesis using the RW algorithm",
                   "The synthesized circuit produces an incorrect mapping: " + static_cast<std::string>(c));
         throw SynthException("Unable to synthesize Circuit");
@@ -476,11 +645,22 @@ Circuit GS_algorithm(const Substitution &sub, bool reduction) {
     }
 
     size_t distance_min = std::numeric_limits<size_t>::max();
+    // every candidate is composed in the same buffer
+    auto candidate = sub_base;
 
     while (sub_base != sub) {
+        check_stop(c);
         Gate best_gate;
+        PROFILE_SCOPE(Phase::CANDIDATE_SCORING);
+        PROFILE_COUNT(Phase::CANDIDATE_SCORING, gates_substitutions.size());
+        size_t scored = 0;
         for (const auto &[g, g_sub]: gates_substitutions) {
-            auto current_distance = cayley_distance(sub_base * g_sub, sub);
+            if (++scored % STOP_CHECK_INTERVAL == 0) {
+                check_stop(c);
+            }
+            candidate = sub_base;
+            candidate *= g_sub;
+            auto current_distance = cayley_distance(candidate, sub);
             if (current_distance < distance_min) {
                 best_gate = g;
                 distance_min = current_distance;
@@ -499,7 +679,7 @@ Circuit GS_algorithm(const Substitution &sub, bool reduction) {
         c.reduce();
     }
 
-    if (c.produce_mapping() != sub) {
+    if (!verify(c, sub)) {
         LOG_DEBUG("Performing synthesis using the GS algorithm",
                   "The synthesized circuit produces an incorrect mapping: " + static_cast<std::string>(c));
         throw SynthException("Unable to synthesize Circuit");
@@ -508,140 +688,336 @@ Circuit GS_algorithm(const Substitution &sub, bool reduction) {
     return c;
 }
 
+Circuit GS_beam_algorithm(const BinaryMapping &bm, size_t width, bool reduction) {
+    auto bm_extended = bm.extend();
+    auto c = GS_beam_algorithm(Substitution(bm_extended), width, reduction);
+    c.set_memory(bm_extended.inputs_number() - bm.inputs_number());
+    return c;
+}
+
+// a partial circuit of the beam is kept as the inverse substitution times the product of its gates, which is the
+// identity for the synthesized circuit, and as its node in the tree of all the partial circuits
+struct beam_state {
+    Substitution left;
+    size_t node;
+};
+
+static Circuit GS_beam_circuit_(const std::vector<std::pair<size_t, size_t>> &tree, size_t node,
+                                const std::vector<Gate> &gates, size_t dim) {
+    std::vector<size_t> path;
+    for (; node; node = tree[node].first) {
+        path.push_back(tree[node].second);
+    }
+    Circuit c(dim);
+    for (auto it = path.rbegin(); it != path.rend(); it++) {
+        c.add(gates[*it]);
+    }
+    return c;
+}
+
+Circuit GS_beam_algorithm(const Substitution &sub, size_t width, bool reduction) {
+    if (!is_power_of_2(sub.power())) {
+        throw SynthException("Substitution size should be power of 2");
+    }
+    if (!width) {
+        throw SynthException("Beam width should be at least 1");
+    }
+
+    const size_t dim = std::log2(sub.power());
+    const auto power = sub.power();
+    if (sub.is_identical()) {
+        return Circuit(dim);
+    }
+
+    const auto gates = generate_all_gates(dim);
+    std::vector<Substitution> gates_substitutions;
+    gates_substitutions.reserve(gates.size());
+    for (const auto &gate: gates) {
+        gates_substitutions.push_back(gate.act());
+    }
+
+    // the parent and the gate of every node, the root is the empty circuit
+    std::vector<std::pair<size_t, size_t>> tree{{0, 0}};
+    std::vector<beam_state> beam{{sub.invert(), 0}};
+    std::unordered_set<Substitution> visited{beam.front().left};
+    // the Cayley distance to the identity
+    size_t best_distance = power - beam.front().left.cycles_number();
+    size_t best_node = 0;
+    size_t steps = 0;
+    size_t plateau = 0;
+
+    // every partial circuit of the beam has steps gates, the closest one is built only once the deadline has passed
+    auto check_beam_stop = [&]() {
+        try {
+            check_stop(steps);
+        } catch (const TimeoutException &) {
+            throw TimeoutException(GS_beam_circuit_(tree, best_node, gates, dim));
+        }
+    };
+
+    while (plateau < power) {
+        check_beam_stop();
+
+        // (Cayley distance, bits the points are moved by, state, gate) of every extension: equal Cayley distances are
+        // common, the points closer to their images break the ties
+        std::vector<std::vector<std::tuple<size_t, size_t, size_t, size_t>>> extensions(beam.size());
+        std::vector<size_t> order(beam.size());
+        std::iota(order.begin(), order.end(), 0);
+        PROFILE_SCOPE(Phase::CANDIDATE_SCORING);
+        PROFILE_COUNT(Phase::CANDIDATE_SCORING, beam.size() * gates.size());
+        parallel_for_each(order, [&](size_t i) {
+            extensions[i].reserve(gates.size());
+            auto left = beam[i].left;
+            for (size_t j = 0; j < gates.size(); j++) {
+                if ((j + 1) % STOP_CHECK_INTERVAL == 0) {
+                    check_beam_stop();
+                }
+                left = beam[i].left;
+                left *= gates_substitutions[j];
+                size_t hamming = 0;
+                for (size_t x = 0; x < power; x++) {
+                    hamming += std::popcount(x ^ left.image(x));
+                }
+                extensions[i].emplace_back(power - left.cycles_number(), hamming, i, j);
+            }
+        });
+        std::vector<std::tuple<size_t, size_t, size_t, size_t>> candidates;
+        for (auto &state_extensions: extensions) {
+            candidates.insert(candidates.end(), state_extensions.begin(), state_extensions.end());
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        std::vector<beam_state> next;
+        bool closer = false;
+        for (const auto &[distance, hamming, i, j]: candidates) {
+            if (next.size() == width) {
+                break;
+            }
+            auto left = beam[i].left * gates_substitutions[j];
+            if (!visited.insert(left).second) {
+                continue;
+            }
+            tree.emplace_back(beam[i].node, j);
+            if (!distance) {
+                auto c = GS_beam_circuit_(tree, tree.size() - 1, gates, dim);
+                if (reduction) {
+                    c.reduce();
+                }
+                if (!verify(c, sub)) {
+                    LOG_DEBUG("Performing synthesis using the beam GS algorithm",
+                              "The synthesized circuit produces an incorrect mapping: " + static_cast<std::string>(c));
+                    throw SynthException("Unable to synthesize Circuit");
+                }
+                return c;
+            }
+            if (distance < best_distance) {
+                best_distance = distance;
+                best_node = tree.size() - 1;
+                closer = true;
+            }
+            next.push_back({std::move(left), tree.size() - 1});
+        }
+        if (next.empty()) {
+            break;
+        }
+        beam = std::move(next);
+        plateau = closer ? 0 : plateau + 1;
+        steps++;
+    }
+
+    LOG_DEBUG("Performing synthesis using the beam GS algorithm",
+              "No closer circuit was found: " + static_cast<std::string>(GS_beam_circuit_(tree, best_node, gates, dim)));
+    throw SynthException("Unable to synthesize Circuit");
+}
+
 Circuit ZKB_algorithm(const BinaryMapping &bm, bool reduction) {
+    return ZKB_algorithm(bm, TranspositionOrder::NATURAL, reduction);
+}
+
+Circuit ZKB_algorithm(const BinaryMapping &bm, TranspositionOrder order, bool reduction) {
     auto bm_extended = bm.extend();
-    auto c = ZKB_algorithm(Substitution(bm_extended), reduction);
+    auto c = ZKB_algorithm(Substitution(bm_extended), order, reduction);
     c.set_memory(bm_extended.inputs_number() - bm.inputs_number());
     return c;
 }
 
-inline std::vector<Gate> ZKB_algorithm(const transposition_type &trans, size_t dim) {
+// masks of lines by the bits of a transposition (x, y): bit (dim - i - 1) stands for line i
+struct zkb_masks {
+    size_t b00;
+    size_t b01;
+    size_t b10;
+};
+
+inline zkb_masks ZKB_masks(const transposition_type &trans, size_t dim) {
     if (trans.first == trans.second) {
         throw SubException("Invalid transposition");
     }
+    size_t full_mask = (size_t(1) << dim) - 1;
+    return {~(trans.first | trans.second) & full_mask, ~trans.first & trans.second & full_mask,
+            trans.first & ~trans.second & full_mask};
+}
 
-    std::set<size_t> b00;
-    std::set<size_t> b01;
-    std::set<size_t> b10;
-    std::set<size_t> b11;
+inline size_t ZKB_gates_number(const zkb_masks &masks) {
+    size_t b01_size = std::popcount(masks.b01);
+    size_t b10_size = std::popcount(masks.b10);
+    if (b01_size + b10_size == 1) {
+        return 1;
+    }
+    if (b01_size && b10_size) {
+        return 2 * (b10_size - 1 + b01_size) + 1;
+    }
+    return 2 * (b01_size + b10_size + 1) + 1;
+}
 
-    for (size_t i = 0; i < dim; i++) {
-        auto bit_pos = dim - i - 1;
-        bool x_bit = (trans.first >> bit_pos) & 1;
-        bool y_bit = (trans.second >> bit_pos) & 1;
-        if (!x_bit && !y_bit) {
-            b00.insert(i);
-        } else if (!x_bit && y_bit) {
-            b01.insert(i);
-        } else if (x_bit && !y_bit) {
-            b10.insert(i);
-        } else {
-            b11.insert(i);
+// writes the gates of a transposition through the output iterator
+template<typename OutputIt>
+inline void ZKB_algorithm(const zkb_masks &masks, size_t dim, OutputIt out) {
+    // the least line of a mask is its most significant bit
+    auto first_line = [dim](size_t mask) {
+        return dim - std::bit_width(mask);
+    };
+    auto cnot_gates = [&](size_t mask, size_t control) {
+        for (; mask; mask &= ~std::bit_floor(mask)) {
+            auto line = first_line(mask);
+            *out++ = Gate(GateType::CNOT, std::vector<size_t>{line}, controls_type({{control, true}}), dim);
         }
-    }
+    };
+    auto not_gate = [&](size_t line) {
+        *out++ = Gate(GateType::NOT, std::vector<size_t>{line}, controls_type{}, dim);
+    };
 
+    size_t j = masks.b10 ? first_line(masks.b10) : first_line(masks.b01);
     controls_type kernel_controls;
     for (size_t control = 0; control < dim; control++) {
-        kernel_controls[control] = !b00.contains(control);
+        if (control != j) {
+            kernel_controls.emplace_hint(kernel_controls.end(), control,
+                                         !((masks.b00 >> (dim - control - 1)) & 1));
+        }
     }
+    // NOT gates skipped - we took them into account by marking kernel inputs inverse
+    auto kernel_gate = [&]() {
+        *out++ = Gate(GateType::kCNOT, std::vector<size_t>{j}, kernel_controls, dim);
+    };
 
-    std::vector<Gate> result;
+    if (std::popcount(masks.b01 | masks.b10) == 1) {
+        kernel_gate();
+        return;
+    }
+
+    if (masks.b01 && masks.b10) {
+        auto k = first_line(masks.b01);
+        auto b10_tail = masks.b10 & ~(size_t(1) << (dim - j - 1));
+        cnot_gates(b10_tail, k);
+        cnot_gates(masks.b01, j);
+        kernel_gate();
+        cnot_gates(masks.b01, j);
+        cnot_gates(b10_tail, k);
+        return;
+    }
+
+    auto tail = (masks.b01 | masks.b10) & ~(size_t(1) << (dim - j - 1));
+    not_gate(j);
+    cnot_gates(tail, j);
+    not_gate(j);
+    kernel_gate();
+    not_gate(j);
+    cnot_gates(tail, j);
+    not_gate(j);
+}
 
-    if (b01.size() + b10.size() == 1) {
-        auto j = b01.empty() ? *b10.begin() : *b01.begin();
-        kernel_controls.extract(j);
-        result.emplace_back(GateType::kCNOT, std::vector<size_t>{j}, kernel_controls, dim);
-        return result;
-    }
+// transpositions of the cycles one by one, in the order they are prepended to a circuit
+inline std::vector<transposition_type> ZKB_transpositions(const Substitution &sub, size_t dim) {
+    auto cost = [dim](size_t x, size_t y) {
+        return ZKB_gates_number(ZKB_masks({x, y}, dim));
+    };
+    // conjugation layers of a transposition depend only on its b01 and b10 masks
+    auto layers_key = [](const transposition_type &trans) {
+        return std::make_pair(~trans.first & trans.second, trans.first & ~trans.second);
+    };
 
-    if (!b01.empty() && !b10.empty()) {
-        auto j = *b10.begin();
-        auto k = *b01.begin();
+    std::vector<std::vector<transposition_type>> cycles_transpositions;
+    for (const auto &cycle: sub.cycles()) {
+        if (cycle.size() < 2) {
+            continue;
+        }
+        const auto k = cycle.size();
 
-        std::vector<Gate> b10_cnot_gates;
-        for (auto i: b10) {
-            if (i == j) {
-                continue;
+        // a chain (c_r, c_r+1), ..., (c_r-2, c_r-1) skips the edge (c_r-1, c_r), so the costliest edge is skipped
+        size_t chain_cost = 0;
+        size_t chain_start = 0;
+        size_t skipped_cost = 0;
+        for (size_t i = 0; i < k; i++) {
+            auto edge_cost = cost(cycle[(i + k - 1) % k], cycle[i]);
+            chain_cost += edge_cost;
+            if (edge_cost > skipped_cost) {
+                skipped_cost = edge_cost;
+                chain_start = i;
             }
-            b10_cnot_gates.emplace_back(
-                    GateType::CNOT,
-                    std::vector<size_t>{i},
-                    controls_type({{k, true}}),
-                    dim
-            );
-        }
-        std::vector<Gate> b01_cnot_gates;
-        for (auto i: b01) {
-            b01_cnot_gates.emplace_back(
-                    GateType::CNOT,
-                    std::vector<size_t>{i},
-                    controls_type({{j, true}}),
-                    dim
-            );
-        }
-        // NOT gates skipped - we took them into account by marking kernel inputs inverse
-        std::copy(b10_cnot_gates.begin(), b10_cnot_gates.end(), std::back_inserter(result));
-        std::copy(b01_cnot_gates.begin(), b01_cnot_gates.end(), std::back_inserter(result));
-        kernel_controls.extract(j);
-        result.emplace_back(GateType::kCNOT, std::vector<size_t>{j}, kernel_controls, dim);
-        std::copy(b01_cnot_gates.begin(), b01_cnot_gates.end(), std::back_inserter(result));
-        std::copy(b10_cnot_gates.begin(), b10_cnot_gates.end(), std::back_inserter(result));
-        return result;
-    }
-
-    if (b01.empty()) {
-        auto j = *b10.begin();
-
-        std::vector<Gate> b10_cnot_gates;
-        b10_cnot_gates.emplace_back(GateType::NOT, std::vector<size_t>{j}, controls_type{}, dim);
-        for (auto i: b10) {
-            if (i == j) {
-                continue;
+        }
+        chain_cost -= skipped_cost;
+
+        // a star (c_p, c_p-1), ..., (c_p, c_p+1) conjugates every element with the pivot
+        size_t star_cost = chain_cost;
+        size_t star_pivot = k;
+        if (k > 2 && k <= ZKB_STAR_THRESHOLD) {
+            for (size_t p = 0; p < k; p++) {
+                size_t pivot_cost = 0;
+                for (size_t i = 0; i < k && pivot_cost < star_cost; i++) {
+                    pivot_cost += i == p ? 0 : cost(cycle[p], cycle[i]);
+                }
+                if (pivot_cost < star_cost) {
+                    star_cost = pivot_cost;
+                    star_pivot = p;
+                }
             }
-            b10_cnot_gates.emplace_back(
-                    GateType::CNOT,
-                    std::vector<size_t>{i},
-                    controls_type({{j, true}}),
-                    dim
-            );
-        }
-        b10_cnot_gates.emplace_back(GateType::NOT, std::vector<size_t>{j}, controls_type{}, dim);
-        // NOT gates skipped - we took them into account by marking kernel inputs inverse
-        std::copy(b10_cnot_gates.begin(), b10_cnot_gates.end(), std::back_inserter(result));
-        kernel_controls.extract(j);
-        result.emplace_back(GateType::kCNOT, std::vector<size_t>{j}, kernel_controls, dim);
-        std::copy(b10_cnot_gates.begin(), b10_cnot_gates.end(), std::back_inserter(result));
-        return result;
-    }
-
-    if (b10.empty()) {
-        auto j = *b01.begin();
+        }
 
-        std::vector<Gate> b01_cnot_gates;
-        b01_cnot_gates.emplace_back(GateType::NOT, std::vector<size_t>{j}, controls_type{}, dim);
-        for (auto i: b01) {
-            if (i == j) {
-                continue;
+        std::vector<transposition_type> transpositions;
+        transpositions.reserve(k - 1);
+        if (star_pivot < k) {
+            for (size_t i = k - 1; i; i--) {
+                transpositions.emplace_back(cycle[star_pivot], cycle[(star_pivot + i) % k]);
             }
-            b01_cnot_gates.emplace_back(
-                    GateType::CNOT,
-                    std::vector<size_t>{i},
-                    controls_type({{j, true}}),
-                    dim
-            );
-        }
-        b01_cnot_gates.emplace_back(GateType::NOT, std::vector<size_t>{j}, controls_type{}, dim);
-        // NOT gates skipped - we took them into account by marking kernel inputs inverse
-        std::copy(b01_cnot_gates.begin(), b01_cnot_gates.end(), std::back_inserter(result));
-        kernel_controls.extract(j);
-        result.emplace_back(GateType::kCNOT, std::vector<size_t>{j}, kernel_controls, dim);
-        std::copy(b01_cnot_gates.begin(), b01_cnot_gates.end(), std::back_inserter(result));
-        return result;
+        } else {
+            for (size_t i = 0; i < k - 1; i++) {
+                transpositions.emplace_back(cycle[(chain_start + i) % k], cycle[(chain_start + i + 1) % k]);
+            }
+        }
+        cycles_transpositions.push_back(std::move(transpositions));
+    }
+
+    // disjoint cycles commute: each next cycle starts with the layers the previous one ends with, when possible
+    std::multimap<std::pair<size_t, size_t>, size_t> by_first_layers;
+    for (size_t i = 0; i < cycles_transpositions.size(); i++) {
+        by_first_layers.emplace(layers_key(cycles_transpositions[i].front()), i);
+    }
+    std::vector<bool> placed(cycles_transpositions.size());
+    std::vector<transposition_type> result;
+    size_t next_unplaced = 0;
+    while (!by_first_layers.empty()) {
+        auto it = result.empty() ? by_first_layers.end() : by_first_layers.find(layers_key(result.back()));
+        if (it == by_first_layers.end()) {
+            while (placed[next_unplaced]) {
+                next_unplaced++;
+            }
+            auto range = by_first_layers.equal_range(layers_key(cycles_transpositions[next_unplaced].front()));
+            it = std::find_if(range.first, range.second, [&](const auto &item) {
+                return item.second == next_unplaced;
+            });
+        }
+        auto i = it->second;
+        by_first_layers.erase(it);
+        placed[i] = true;
+        std::copy(cycles_transpositions[i].begin(), cycles_transpositions[i].end(), std::back_inserter(result));
     }
     return result;
 }
 
 Circuit ZKB_algorithm(const Substitution &sub, bool reduction) {
+    return ZKB_algorithm(sub, TranspositionOrder::NATURAL, reduction);
+}
+
+Circuit ZKB_algorithm(const Substitution &sub, TranspositionOrder order, bool reduction) {
     if (!is_power_of_2(sub.power())) {
         throw SynthException("Substitution size should be power of 2");
     }
@@ -657,17 +1033,59 @@ Circuit ZKB_algorithm(const Substitution &sub, bool reduction) {
         return c;
     }
 
-    for (const auto &trans: sub.transpositions()) {
-        for (const auto &gate: ZKB_algorithm(trans, dim)) {
-            c.insert(gate, 0);
+    auto transpositions = order == TranspositionOrder::OPTIMIZED ? ZKB_transpositions(sub, dim) : sub.transpositions();
+    std::vector<zkb_masks> masks;
+    masks.reserve(transpositions.size());
+    std::vector<size_t> offsets{0};
+    offsets.reserve(transpositions.size() + 1);
+    for (const auto &trans: transpositions) {
+        masks.push_back(ZKB_masks(trans, dim));
+        offsets.push_back(offsets.back() + ZKB_gates_number(masks.back()));
+    }
+
+    // the number of gates is known before any of them is built, the optimized order only cancels some of them
+    check_stop(order == TranspositionOrder::NATURAL ? offsets.back() : 0);
+
+    // every transposition is prepended to the circuit, so the buffer is filled from its end
+    std::vector<Gate> gates(offsets.back());
+    const auto *stop = current_stop_condition;
+    auto process_range = [&](size_t start, size_t end) {
+        for (size_t i = start; i < end; i++) {
+            check_stop(stop);
+            ZKB_algorithm(masks[i], dim, gates.rbegin() + static_cast<std::ptrdiff_t>(offsets[i]));
+        }
+    };
+
+    size_t num_threads = inside_parallel_task ? 1 : JobsConfig::instance().get();
+    size_t batch_size = (transpositions.size() + num_threads - 1) / num_threads;
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < transpositions.size(); i += batch_size) {
+        futures.push_back(std::async(std::launch::async, process_range, i,
+                                     std::min(i + batch_size, transpositions.size())));
+    }
+    for (auto &future: futures) {
+        future.get();
+    }
+
+    if (order == TranspositionOrder::OPTIMIZED) {
+        // gates are involutions, so equal conjugation layers of neighbouring transpositions cancel out
+        size_t size = 0;
+        for (size_t i = 0; i < gates.size(); i++) {
+            if (size && gates[size - 1] == gates[i]) {
+                size--;
+            } else if (size++ != i) {
+                gates[size - 1] = std::move(gates[i]);
+            }
         }
+        gates.resize(size);
     }
+    c.add(std::move(gates));
 
     if (reduction) {
         c.reduce();
     }
 
-    if (c.produce_mapping() != sub) {
+    if (!verify(c, sub)) {
         LOG_DEBUG("Performing synthesis using the ZKB algorithm",
                   "The synthesized circuit produces an incorrect mapping: " + static_cast<std::string>(c));
         throw SynthException("Unable to synthesize Circuit");
@@ -683,35 +1101,88 @@ Circuit CA_algorithm(const BinaryMapping &bm, bool reduction) {
     return c;
 }
 
+cycle_cache &CA_cache() {
+    static cycle_cache cache(CA_CACHE_CAPACITY);
+    return cache;
+}
+
+Circuit CA_cycle_synthesis(const cycle_type &cycle) {
+    auto canonical_cycle = cycle;
+    std::rotate(canonical_cycle.begin(), std::min_element(canonical_cycle.begin(), canonical_cycle.end()),
+                canonical_cycle.end());
+    const auto cycle_sub = substitution_power_of_2_by_cycle(canonical_cycle);
+    const auto key = std::make_pair(static_cast<size_t>(std::log2(cycle_sub.power())), canonical_cycle);
+    if (auto cached = CA_cache().get(key)) {
+        return *cached;
+    }
+
+    auto synthesize_cycle = [&]() {
+        if (cycle_sub.power() <= 1u << OPT_MAX_DIM) {
+            return OPT_algorithm(cycle_sub);
+        }
+        if (cycle.size() < CA_THRESHOLD) {
+            try {
+                return GS_algorithm(cycle_sub);
+            } catch (SynthException &e) {
+                LOG_DEBUG("Performing synthesis using the CA algorithm",
+                          "GS fucked up: " + static_cast<std::string>(e.what()));
+            }
+        }
+        return ZKB_algorithm(cycle_sub);
+    };
+
+    auto c = synthesize_cycle();
+    CA_cache().put(key, c);
+    return c;
+}
+
 Circuit CA_algorithm(const Substitution &sub, bool reduction) {
     if (!is_power_of_2(sub.power())) {
         throw SynthException("Substitution size should be power of 2");
     }
 
     if (sub.power() < CA_THRESHOLD) {
-        return GS_algorithm(sub, reduction);
+        return OPT_algorithm(sub, reduction);
     }
 
     size_t dim = std::log2(sub.power());
     Circuit c(dim);
 
-    for (const auto &cycle: sub.cycles()) {
-        const auto cycle_sub = substitution_power_of_2_by_cycle(cycle);
-        if (cycle.size() < CA_THRESHOLD) {
-            try {
-                c.inject(GS_algorithm(cycle_sub));
-            } catch (SynthException &e) {
-                LOG_DEBUG("Performing synthesis using the CA algorithm",
-                          "GS fucked up: " + static_cast<std::string>(e.what()));
-                c.inject(ZKB_algorithm(cycle_sub));
-            }
-            continue;
+    auto cycles = sub.cycles();
+    // fixed points need no gates
+    std::erase_if(cycles, [](const auto &cycle) {
+        return cycle.size() < 2;
+    });
+
+    // longest cycles are the most expensive ones, so they are taken first
+    std::vector<size_t> order(cycles.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t i, size_t j) {
+        return cycles[i].size() > cycles[j].size();
+    });
+
+    std::vector<std::optional<Circuit>> circuits(cycles.size());
+    std::atomic<size_t> gates_number = 0;
+    std::atomic<bool> timed_out = false;
+    parallel_for_each(order, [&](size_t i) {
+        try {
+            check_stop(gates_number.load());
+            circuits[i] = CA_cycle_synthesis(cycles[i]);
+            gates_number += circuits[i]->complexity();
+        } catch (const TimeoutException &) {
+            timed_out = true;
         }
-        if (cycle.size() >= CA_THRESHOLD) {
-            c.inject(ZKB_algorithm(cycle_sub));
-            continue;
+    });
+
+    // cycles are disjoint, so the finished ones make a circuit of their own
+    for (const auto &cycle_circuit: circuits) {
+        if (cycle_circuit) {
+            c.inject(*cycle_circuit);
         }
     }
+    if (timed_out) {
+        throw TimeoutException(c);
+    }
 
     if (reduction) {
         c.reduce();
@@ -725,3 +1196,34 @@ Circuit CA_algorithm(const Substitution &sub, bool reduction) {
 
     return c;
 }
+
+Circuit OPT_algorithm(const BinaryMapping &bm, bool reduction) {
+    auto bm_extended = bm.extend();
+    auto c = OPT_algorithm(Substitution(bm_extended), reduction);
+    c.set_memory(bm_extended.inputs_number() - bm.inputs_number());
+    return c;
+}
+
+Circuit OPT_algorithm(const Substitution &sub, bool reduction) {
+    if (!is_power_of_2(sub.power())) {
+        throw SynthException("Substitution size should be power of 2");
+    }
+    if (sub.power() > 1u << OPT_MAX_DIM) {
+        throw SynthException("Impossible to apply the OPT algorithm to a substitution of power greater than " +
+                             std::to_string(1u << OPT_MAX_DIM));
+    }
+
+    auto c = OptimalDatabase::instance().circuit(sub);
+
+    if (reduction) {
+        c.reduce();
+    }
+
+    if (!verify(c, sub)) {
+        LOG_DEBUG("Performing synthesis using the OPT algorithm",
+                  "The synthesized circuit produces an incorrect mapping: " + static_cast<std::string>(c));
+        throw SynthException("Unable to synthesize Circuit");
+    }
+
+    return c;
+}
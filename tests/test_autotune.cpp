@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include "test_utils.hpp"
+
+TEST(Autotune, Features) {
+    auto features = synthesis_features(Substitution(std::vector<size_t>{1, 0, 3, 2, 4, 5, 7, 6}));
+    EXPECT_EQ(features.dim, 3);
+    EXPECT_FALSE(features.is_mapping);
+    EXPECT_EQ(features.cycles, 5);
+    EXPECT_EQ(features.cycle_points[0], 2);
+    EXPECT_EQ(features.cycle_points[1], 6);
+
+    auto x = features.vector();
+    EXPECT_DOUBLE_EQ(x[0], 1);
+    EXPECT_DOUBLE_EQ(x[1], 3);
+    EXPECT_DOUBLE_EQ(x[3], 5. / 8);
+    EXPECT_DOUBLE_EQ(x[4 + 1], 6. / 8);
+
+    // an irreversible mapping is described by its extension
+    BinaryMapping bm(table{{0, 0, 0, 1}});
+    auto bm_features = synthesis_features(bm);
+    EXPECT_EQ(bm_features.dim, 3);
+    EXPECT_TRUE(bm_features.is_mapping);
+}
+
+static void load_model(const std::string &s) {
+    std::stringstream ss(s);
+    CostModel::instance().load(ss);
+}
+
+TEST(Autotune, Model) {
+    ScopedCostModel cost_model;
+
+    // ZKB is always slower by a constant factor but never fails, GS is fast and fails beyond 3 lines
+    std::vector<CostSample> samples;
+    std::mt19937_64 generator(1);
+    for (size_t dim = 2; dim <= 6; dim++) {
+        for (size_t i = 0; i < 4; i++) {
+            auto features = synthesis_features(random_substitution(dim, generator));
+            auto seconds = std::pow(2., static_cast<double>(dim)) * 1e-6;
+            samples.push_back({Algo::ZKB, features, seconds * 16, dim * 10, false});
+            samples.push_back({Algo::GS, features, seconds, dim * 10, dim > 3});
+        }
+    }
+    auto coefficients = CostModel::fit(samples);
+    ASSERT_TRUE(coefficients.contains(Algo::ZKB));
+    ASSERT_TRUE(coefficients.contains(Algo::GS));
+    EXPECT_FALSE(coefficients.contains(Algo::CA));
+    EXPECT_EQ(coefficients[Algo::ZKB].max_dim, 6);
+    EXPECT_EQ(coefficients[Algo::GS].max_dim, 3);
+
+    load_model("# cost model\n");
+    for (const auto &[algo, algo_coefficients]: coefficients) {
+        CostModel::instance().set(algo, algo_coefficients);
+    }
+    auto small = synthesis_features(Substitution(std::vector<size_t>{1, 2, 3, 4, 5, 6, 7, 0}));
+    auto prediction = CostModel::instance().predict(Algo::ZKB, small);
+    EXPECT_NEAR(prediction.log2_seconds, std::log2(8 * 16 * 1e-6), 0.5);
+    EXPECT_LT(CostModel::instance().predict(Algo::GS, small).failure, 0.5);
+
+    auto ranking = CostModel::instance().rank(small);
+    ASSERT_EQ(ranking.size(), AUTO_CANDIDATES.size());
+    EXPECT_EQ(ranking[0], Algo::GS);
+    EXPECT_EQ(ranking[1], Algo::ZKB);
+    // GS was never seen succeeding on 5 lines
+    std::vector<size_t> images(32);
+    std::iota(images.begin(), images.end(), 0);
+    std::reverse(images.begin(), images.end());
+    EXPECT_EQ(CostModel::instance().rank(synthesis_features(Substitution(images)))[0], Algo::ZKB);
+
+    std::stringstream saved;
+    CostModel::instance().save(saved);
+    CostModel::instance().load(saved);
+    EXPECT_DOUBLE_EQ(CostModel::instance().predict(Algo::ZKB, small).log2_seconds, prediction.log2_seconds);
+
+    EXPECT_THROW(load_model("# model\n"), IOException);
+    EXPECT_THROW(load_model("# cost model\nopt 3 1 2\n"), IOException);
+    EXPECT_THROW(CostModel::instance().set(Algo::OPT, {}), SynthException);
+}
+
+TEST(Autotune, Synthesis) {
+    std::mt19937_64 generator(7);
+    for (size_t dim = 1; dim <= 6; dim++) {
+        auto sub = random_substitution(dim, generator);
+        auto c = synthesize(sub, Algo::AUTO);
+        EXPECT_EQ(Substitution(c.produce_mapping()), sub);
+    }
+
+    BinaryMapping bm(table{{1, 1, 0, 1, 0, 0, 1, 0},
+                           {0, 1, 1, 1, 1, 0, 0, 0}});
+    auto c = synthesize(bm, Algo::AUTO);
+    EXPECT_EQ(c.dim(), 5);
+    EXPECT_EQ(c.memory(), 2);
+    for (size_t x = 0; x < 8; x++) {
+        EXPECT_EQ(c.act(uint64_t(x << 2)) & 3, bm.row(x));
+    }
+}
@@ -89,6 +89,30 @@ TEST(BooleanFunction, Methods) {
     EXPECT_THROW([[maybe_unused]] auto _ = BooleanFunction("1111").variable(), BFException);
     EXPECT_THROW([[maybe_unused]] auto _ = BooleanFunction("10101010").variable(), BFException);
     EXPECT_THROW([[maybe_unused]] auto _ = BooleanFunction("11111111111111110000000000000000").variable(), BFException);
+    for (size_t dim: {1, 3, 6, 7, 9}) {
+        for (size_t n = 0; n < dim; n++) {
+            BooleanFunction bf(n, dim);
+            EXPECT_EQ(bf.variable(), n);
+            EXPECT_TRUE(bf.is_variable(n));
+            EXPECT_FALSE(bf.is_variable(n, true));
+            EXPECT_FALSE(bf.is_variable(dim));
+            auto bf_inverted = ~BooleanFunction(bf);
+            EXPECT_TRUE(bf_inverted.is_variable(n, true));
+            EXPECT_FALSE(bf_inverted.is_variable(n));
+            EXPECT_THROW([[maybe_unused]] auto _ = bf_inverted.variable(), BFException);
+            if (n + 1 < dim) {
+                EXPECT_FALSE(bf.is_variable(n + 1));
+                EXPECT_THROW([[maybe_unused]] auto _ = (bf + BooleanFunction(n + 1, dim)).variable(), BFException);
+            }
+        }
+    }
+    {
+        // differs from x_0 only in the middle word
+        auto v = BooleanFunction(0ul, 8).vector();
+        v[100] = !v[100];
+        EXPECT_FALSE(BooleanFunction(v).is_variable(0));
+        EXPECT_THROW([[maybe_unused]] auto _ = BooleanFunction(v).variable(), BFException);
+    }
 
     EXPECT_EQ(bf_1.vector(), binary_vector({true, false, false, false, true, false, true, false}));
     EXPECT_EQ(bf_2.vector(), binary_vector({false, true}));
@@ -120,6 +144,24 @@ TEST(BooleanFunction, Methods) {
     EXPECT_EQ(BooleanFunction("11101101").mobius_transformation(), (std::vector<bool>{1, 0, 0, 1, 0, 0, 1, 0}));
     EXPECT_EQ(BooleanFunction("00010010").mobius_transformation(), (std::vector<bool>{0, 0, 0, 1, 0, 0, 1, 0}));
     EXPECT_EQ(BooleanFunction("10000000").mobius_transformation(), (std::vector<bool>{1, 1, 1, 1, 1, 1, 1, 1}));
+    {
+        // the transform is an involution, over in-word and whole-word stages alike
+        binary_vector v(1 << 9);
+        for (size_t i = 0; i < v.size(); i++) {
+            v[i] = (i * 7 + i / 3) % 5 < 2;
+        }
+        BooleanFunction bf(v);
+        EXPECT_EQ(BooleanFunction(BooleanFunction(bf.mobius_transformation()).mobius_transformation()), bf);
+    }
+
+    EXPECT_EQ(BooleanFunction("0000").monomials(), (std::vector<size_t>{}));
+    EXPECT_EQ(BooleanFunction("1111").monomials(), (std::vector<size_t>{0}));
+    EXPECT_EQ(BooleanFunction("1001").monomials(), (std::vector<size_t>{0, 1, 2}));
+    EXPECT_EQ(BooleanFunction("0011").monomials(), (std::vector<size_t>{2}));
+    EXPECT_EQ(BooleanFunction("11101101").monomials(), (std::vector<size_t>{0, 3, 6}));
+    EXPECT_EQ(BooleanFunction(0ul, 7).monomials(), (std::vector<size_t>{64}));
+    EXPECT_EQ(BooleanFunction(6ul, 7).monomials(), (std::vector<size_t>{1}));
+    EXPECT_EQ((BooleanFunction(0ul, 8) * BooleanFunction(7ul, 8)).monomials(), (std::vector<size_t>{129}));
 
     EXPECT_EQ(BooleanFunction("01").RW_spectrum(), (std::vector<int>{1, -1}));
     EXPECT_EQ(BooleanFunction("00").RW_spectrum(), (std::vector<int>{0, 0}));
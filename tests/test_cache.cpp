@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include "cache.hpp"
+
+TEST(Cache, LRU) {
+    LRUCache<int, std::string> cache(2);
+    EXPECT_EQ(cache.capacity(), 2);
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.get(1), std::nullopt);
+
+    cache.put(1, "a");
+    cache.put(2, "b");
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get(1), "a");
+
+    // 2 is the least recently used entry now
+    cache.put(3, "c");
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get(2), std::nullopt);
+    EXPECT_EQ(cache.get(1), "a");
+    EXPECT_EQ(cache.get(3), "c");
+
+    cache.put(3, "d");
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.get(3), "d");
+
+    cache.set_capacity(1);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.get(3), "d");
+    EXPECT_EQ(cache.get(1), std::nullopt);
+
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.get(3), std::nullopt);
+
+    cache.set_capacity(0);
+    cache.put(1, "a");
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.get(1), std::nullopt);
+}
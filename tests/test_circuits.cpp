@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
 #include "gates.hpp"
+#include "jobs.hpp"
+#include "test_utils.hpp"
 
 
 TEST(Circuits, Constructor) {
@@ -64,6 +66,15 @@ TEST(Circuits, Insert) {
     EXPECT_EQ(c.complexity(), 5);
 
     EXPECT_EQ(c, Circuit("Lines: 3\nNOT(0)\nkCNOT(1; !0, 2)\nSWAP(0, 2)\nCNOT(1; 0)\nCSWAP(0, 2; !1)"));
+
+    EXPECT_THROW(c.add(std::vector<Gate>{Gate("NOT(0)", 3), Gate("NOT(0)", 2)}), CircuitException);
+    EXPECT_EQ(c.complexity(), 5);
+    c.add(std::vector<Gate>{Gate("NOT(2)", 3), Gate("SWAP(0, 1)", 3)});
+    EXPECT_EQ(c, Circuit("Lines: 3\nNOT(0)\nkCNOT(1; !0, 2)\nSWAP(0, 2)\nCNOT(1; 0)\nCSWAP(0, 2; !1)\nNOT(2)\n"
+                         "SWAP(0, 1)"));
+    Circuit c_empty("Lines: 3");
+    c_empty.add(std::vector<Gate>{Gate("NOT(2)", 3)});
+    EXPECT_EQ(c_empty, Circuit("Lines: 3\nNOT(2)"));
 }
 
 TEST(Circuits, Act) {
@@ -103,6 +114,71 @@ TEST(Circuits, Act) {
     EXPECT_EQ(vec_bf3, (std::vector<BooleanFunction>{BooleanFunction("0100"), BooleanFunction("0010")}));
 }
 
+TEST(Circuits, ActKernels) {
+    // specialized widths and the generic path beyond KERNEL_MAX_DIM must agree with the action on rows
+    for (size_t dim: {size_t(4), size_t(6), size_t(7), KERNEL_MAX_DIM, KERNEL_MAX_DIM + 1}) {
+        Circuit c(dim);
+        c.add(Gate("NOT(1)", dim));
+        c.add(Gate("CNOT(0; !" + std::to_string(dim - 1) + ")", dim));
+        c.add(Gate("kCNOT(2; 0, !1, " + std::to_string(dim - 1) + ")", dim));
+        c.add(Gate("SWAP(0, " + std::to_string(dim - 2) + ")", dim));
+        c.add(Gate("CSWAP(1, 2; " + std::to_string(dim - 1) + ")", dim));
+        c.add(Gate("SWAP(1, " + std::to_string(dim - 1) + ")", dim));
+        c.add(Gate("CSWAP(0, 1; !2)", dim));
+
+        auto cf = c.produce_mapping().coordinate_functions();
+        for (size_t x: {size_t(0), size_t(1), size_t(5), (size_t(1) << dim) - 3, (size_t(1) << dim) - 1}) {
+            binary_vector row;
+            for (size_t i = 0; i < dim; i++) {
+                row.push_back((x >> (dim - i - 1)) & 1);
+            }
+            c.act(row);
+            for (size_t i = 0; i < dim; i++) {
+                EXPECT_EQ(cf[i].vector()[x], row[i]) << dim;
+            }
+        }
+    }
+}
+
+TEST(Circuits, ActRows) {
+    for (size_t dim: {size_t(3), size_t(8), size_t(20), size_t(64)}) {
+        Circuit c(dim);
+        c.add(Gate("NOT(1)", dim));
+        c.add(Gate("CNOT(0; !" + std::to_string(dim - 1) + ")", dim));
+        c.add(Gate("kCNOT(2; 0, !1)", dim));
+        c.add(Gate("SWAP(0, " + std::to_string(dim - 2) + ")", dim));
+        c.add(Gate("CSWAP(0, 1; !2)", dim));
+        c.set_memory(1);
+
+        // batched rows span several blocks, spot-checked against the action on binary vectors
+        std::vector<uint64_t> rows(10000);
+        for (size_t x = 0; x < rows.size(); x++) {
+            rows[x] = (x * 0x9E3779B97F4A7C15ull) >> (64 - dim);
+        }
+        auto images = rows;
+        {
+            ScopedJobs jobs(4);
+            c.act(std::span<uint64_t>(images));
+        }
+        for (size_t x = 0; x < rows.size(); x += 97) {
+            binary_vector row;
+            for (size_t i = 0; i < dim; i++) {
+                row.push_back((rows[x] >> (dim - i - 1)) & 1);
+            }
+            c.act(row);
+            uint64_t expected = 0;
+            for (size_t i = 0; i < dim; i++) {
+                expected |= uint64_t(row[i]) << (dim - i - 1);
+            }
+            EXPECT_EQ(images[x], expected) << dim;
+            EXPECT_EQ(c.act(rows[x]), expected) << dim;
+        }
+    }
+
+    EXPECT_THROW((void) Circuit(3).act(uint64_t(8)), CircuitException);
+    EXPECT_THROW((void) Circuit(65).act(uint64_t(0)), CircuitException);
+}
+
 TEST(Circuits, Memory) {
     Circuit c("Lines: 4");
     EXPECT_EQ(c.memory(), 0);
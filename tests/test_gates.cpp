@@ -437,6 +437,36 @@ TEST(Gates, ActCSWAP) {
                                                         BooleanFunction("11111110")}));
 }
 
+TEST(Gates, ActBFWords) {
+    // functions of 8 variables span several words, the result must agree with the action on every row
+    for (const auto &s: {"NOT(5)", "CNOT(7; 0)", "CNOT(0; !6)", "kCNOT(3; 0, !6, 7)", "kCNOT(6; !1, !2, !7)",
+                         "SWAP(1, 7)", "CSWAP(0, 6; 7)", "CSWAP(2, 7; !0)"}) {
+        Gate g(s, 8);
+        cf_set cf;
+        for (size_t i = 0; i < 8; i++) {
+            binary_vector v(1 << 8);
+            for (size_t x = 0; x < v.size(); x++) {
+                v[x] = (x * (2 * i + 3) + i) % 7 < 3;
+            }
+            cf.emplace_back(v);
+        }
+        auto cf_copy = cf;
+        g.act(cf);
+        for (size_t x = 0; x < (1 << 8); x++) {
+            binary_vector row;
+            for (const auto &bf: cf_copy) {
+                row.push_back(bf.vector()[x]);
+            }
+            g.act(row);
+            for (size_t i = 0; i < 8; i++) {
+                EXPECT_EQ(cf[i].vector()[x], row[i]) << s;
+            }
+        }
+        g.act_unchecked(cf);
+        EXPECT_EQ(cf, cf_copy) << s;
+    }
+}
+
 TEST(Gates, Stream) {
     std::stringstream out_stream;
 
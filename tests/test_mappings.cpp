@@ -158,6 +158,49 @@ TEST(BinaryMappings, Methods) {
     EXPECT_EQ(bm1_ext.inputs_number(), bm1.inputs_number() + bm1.outputs_number());
     EXPECT_EQ(bm1_ext.outputs_number(), bm1.inputs_number() + bm1.outputs_number());
 
+    // several outputs above and below a word of rows, checked against the lazy view
+    for (size_t outputs: {size_t(2), size_t(7)}) {
+        cf_set cf;
+        for (size_t k = 0; k < outputs; k++) {
+            binary_vector v(8);
+            for (size_t x = 0; x < v.size(); x++) {
+                v[x] = (x * (k + 3) + k) % 5 < 2;
+            }
+            cf.emplace_back(v);
+        }
+        BinaryMapping bm2(cf);
+        auto bm2_ext = bm2.extend();
+        ExtensionView view(bm2);
+        EXPECT_EQ(view.inputs_number(), bm2_ext.inputs_number());
+        for (size_t x = 0; x < size_t(1) << view.inputs_number(); x++) {
+            EXPECT_EQ(view.row(x), bm2_ext.row(x));
+        }
+        EXPECT_THROW((void) view.row(size_t(1) << view.inputs_number()), BMException);
+    }
+
+    // outputs are the last lines of the embedding, inputs are the first ones
+    auto check_minimal = [](const BinaryMapping &mapping, size_t dim) {
+        auto mapping_ext = mapping.extend(Embedding::MINIMAL_GARBAGE);
+        EXPECT_TRUE(mapping_ext.is_substitution());
+        EXPECT_EQ(mapping_ext.inputs_number(), dim);
+        const auto shift = dim - mapping.inputs_number();
+        const auto outputs_mask = (uint64_t(1) << mapping.outputs_number()) - 1;
+        for (size_t x = 0; x < size_t(1) << mapping.inputs_number(); x++) {
+            EXPECT_EQ(mapping_ext.row(x << shift) & outputs_mask, mapping.row(x));
+        }
+    };
+    check_minimal(BinaryMapping(table{{0, 0, 0, 0, 1, 1, 1, 1},
+                                      {0, 1, 1, 0, 0, 1, 1, 0}}), 3);
+    check_minimal(BinaryMapping(table{{0, 0, 0, 0, 0, 0, 0, 1},
+                                      {0, 0, 0, 0, 0, 0, 1, 0}}), 5);
+    check_minimal(BinaryMapping(table{{1, 1, 1, 1}}), 3);
+    check_minimal(BinaryMapping(table{{0, 1, 1, 0}}), 2);
+    check_minimal(BinaryMapping(table{{0, 1},
+                                      {1, 0}}), 2);
+    check_minimal(BinaryMapping(table{{0, 1},
+                                      {0, 1},
+                                      {1, 1}}), 3);
+    EXPECT_EQ(bm1.extend(Embedding::MINIMAL_GARBAGE).inputs_number(), 3);
 }
 
 TEST(BinaryMapping, Stream) {
@@ -103,3 +103,27 @@ TEST(Math, Bits) {
     EXPECT_EQ(bits_mask(15, 4), (std::vector<size_t>{0, 1, 2, 3}));
     EXPECT_EQ(bits_mask(15, 10), (std::vector<size_t>{6, 7, 8, 9}));
 }
+
+TEST(Math, Permutations) {
+    EXPECT_EQ(factorial(0), 1);
+    EXPECT_EQ(factorial(8), 40320);
+    EXPECT_EQ(factorial(20), 2432902008176640000);
+    EXPECT_THROW(factorial(21), MathException);
+
+    EXPECT_EQ(permutation_rank(std::vector<size_t>{0, 1, 2, 3}), 0);
+    EXPECT_EQ(permutation_rank(std::vector<size_t>{0, 1, 3, 2}), 1);
+    EXPECT_EQ(permutation_rank(std::vector<size_t>{3, 2, 1, 0}), 23);
+    EXPECT_EQ(permutation_by_rank(0, 4), (std::vector<size_t>{0, 1, 2, 3}));
+    EXPECT_EQ(permutation_by_rank(1, 4), (std::vector<size_t>{0, 1, 3, 2}));
+    EXPECT_EQ(permutation_by_rank(23, 4), (std::vector<size_t>{3, 2, 1, 0}));
+    EXPECT_THROW(permutation_by_rank(24, 4), MathException);
+
+    std::vector<size_t> p(6);
+    std::iota(p.begin(), p.end(), 0);
+    size_t rank = 0;
+    do {
+        EXPECT_EQ(permutation_rank(p), rank);
+        EXPECT_EQ(permutation_by_rank(rank, p.size()), p);
+        rank++;
+    } while (std::next_permutation(p.begin(), p.end()));
+}
@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include "test_utils.hpp"
+
+TEST(Portfolio, StopCondition) {
+    StopCondition condition;
+    EXPECT_FALSE(condition.stop_requested());
+    condition.tighten_bound(10);
+    condition.tighten_bound(20);
+    EXPECT_EQ(condition.bound(), 10);
+    EXPECT_FALSE(condition.stop_requested(10));
+    EXPECT_TRUE(condition.stop_requested(11));
+
+    std::mt19937_64 generator(1);
+    auto sub = random_substitution(4, generator);
+    // a racer as long as the best circuit is not cancelled, so the earlier of equal circuits can be kept. RW polls
+    // its finished circuit before it checks the mapping
+    Substitution cnot(Gate(GateType::CNOT, {1}, {{0, true}}, 3).act());
+    for (const auto &tied_sub: {sub, cnot}) {
+        for (auto algo: {Algo::RW, Algo::ZKB, Algo::CA}) {
+            auto length = synthesize(tied_sub, algo).complexity();
+            StopCondition tied;
+            tied.tighten_bound(length);
+            StopScope scope(&tied);
+            EXPECT_EQ(synthesize(tied_sub, algo).complexity(), length);
+        }
+    }
+    {
+        StopCondition unbounded;
+        StopScope scope(&unbounded);
+        EXPECT_NO_THROW(synthesize(sub, Algo::CA));
+    }
+    {
+        StopScope scope(&condition);
+        condition.request_stop();
+        EXPECT_THROW(synthesize(sub, Algo::GS), CancelledException);
+        EXPECT_THROW(synthesize(sub, Algo::ZKB), CancelledException);
+        EXPECT_THROW(synthesize(sub, Algo::CA), CancelledException);
+    }
+    EXPECT_EQ(current_stop_condition, nullptr);
+
+    StopCondition expired;
+    expired.set_deadline(synthesis_clock::now());
+    EXPECT_TRUE(expired.stop_requested());
+}
+
+TEST(Portfolio, Best) {
+    std::mt19937_64 generator(3);
+    {
+        ScopedJobs jobs(4);
+        for (size_t dim = 3; dim <= 5; dim++) {
+            auto sub = random_substitution(dim, generator);
+            size_t shortest = std::numeric_limits<size_t>::max();
+            size_t longest = 0;
+            for (auto algo: PORTFOLIO_ALGORITHMS) {
+                try {
+                    auto c = synthesize(sub, algo);
+                    if (Substitution(c.produce_mapping()) != sub) {
+                        continue;
+                    }
+                    shortest = std::min(shortest, c.complexity());
+                    longest = std::max(longest, c.complexity());
+                } catch (const SynthException &) {
+                }
+            }
+
+            auto c = synthesize(sub, Algo::PORTFOLIO);
+            EXPECT_EQ(Substitution(c.produce_mapping()), sub);
+            EXPECT_EQ(c.complexity(), shortest);
+
+            // a custom metric is not bounded by the partial circuits
+            ScopedPortfolioConfig portfolio_config;
+            PortfolioConfig::instance().set_metric([](const Circuit &circuit) {
+                return -static_cast<double>(circuit.complexity());
+            });
+            EXPECT_EQ(synthesize(sub, Algo::PORTFOLIO).complexity(), longest);
+        }
+    }
+
+    BinaryMapping bm(table{{1, 1, 0, 1, 0, 0, 1, 0},
+                           {0, 1, 1, 1, 1, 0, 0, 0}});
+    auto c = synthesize(bm, Algo::PORTFOLIO);
+    EXPECT_EQ(c.memory(), 2);
+    for (size_t x = 0; x < 8; x++) {
+        EXPECT_EQ(c.act(uint64_t(x << 2)) & 3, bm.row(x));
+    }
+}
+
+TEST(Portfolio, Deadline) {
+    ScopedPortfolioConfig portfolio_config;
+    std::mt19937_64 generator(5);
+    auto sub = random_substitution(8, generator);
+    PortfolioConfig::instance().set_algorithms({Algo::GS, Algo::RW});
+    PortfolioConfig::instance().set_timeout(std::chrono::milliseconds(1));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_THROW(synthesize(sub, Algo::PORTFOLIO), TimeoutException);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    EXPECT_THROW(PortfolioConfig::instance().set_algorithms({Algo::ZKB, Algo::PORTFOLIO}), SynthException);
+    EXPECT_THROW(PortfolioConfig::instance().set_algorithms({}), SynthException);
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include <thread>
+
+#include "profiler.hpp"
+#include "synthesis.hpp"
+
+TEST(Profiler, Records) {
+    auto &profiler = Profiler::instance();
+    profiler.reset();
+
+    {
+        ScopedTimer timer(Phase::REDUCTION);
+        profiler.count(Phase::REDUCTION, 3);
+    }
+    // finished threads are folded into the records
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&profiler]() {
+            ScopedTimer timer(Phase::PARSING);
+            profiler.count(Phase::PARSING, 2);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    auto records = profiler.records();
+    EXPECT_EQ(records[static_cast<size_t>(Phase::REDUCTION)].calls, 1);
+    EXPECT_EQ(records[static_cast<size_t>(Phase::REDUCTION)].items, 3);
+    EXPECT_EQ(records[static_cast<size_t>(Phase::PARSING)].calls, 4);
+    EXPECT_EQ(records[static_cast<size_t>(Phase::PARSING)].items, 8);
+    EXPECT_EQ(records[static_cast<size_t>(Phase::SIMULATION)].calls, 0);
+
+    auto json = profiler.to_json();
+    for (size_t i = 0; i < Profiler::PHASES_NUMBER; i++) {
+        EXPECT_NE(json.find('"' + Profiler::to_string(static_cast<Phase>(i)) + '"'), std::string::npos);
+    }
+    EXPECT_NE(json.find("\"reduction\": {\"calls\": 1,"), std::string::npos);
+
+    profiler.reset();
+    for (const auto &record: profiler.records()) {
+        EXPECT_EQ(record.calls, 0);
+        EXPECT_EQ(record.nanoseconds, 0);
+        EXPECT_EQ(record.items, 0);
+    }
+}
+
+#ifdef QCS_PROFILING
+TEST(Profiler, Phases) {
+    auto &profiler = Profiler::instance();
+    profiler.reset();
+    auto c = synthesize(Substitution("1 0 3 2 5 4 7 6"), Algo::GS, true);
+    (void) static_cast<std::string>(c);
+
+    auto records = profiler.records();
+    for (auto phase: {Phase::SYNTHESIS, Phase::GATE_GENERATION, Phase::CANDIDATE_SCORING, Phase::SIMULATION,
+                      Phase::VERIFICATION, Phase::REDUCTION, Phase::PARSING, Phase::FORMATTING}) {
+        EXPECT_GT(records[static_cast<size_t>(phase)].calls, 0) << Profiler::to_string(phase);
+    }
+    EXPECT_GT(records[static_cast<size_t>(Phase::CANDIDATE_SCORING)].items, 0);
+    profiler.reset();
+}
+#endif
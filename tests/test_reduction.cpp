@@ -1286,4 +1286,13 @@ TEST(Reduction, Reduction) {
         EXPECT_EQ(c.complexity(), 5);  // см отчет
         EXPECT_FALSE(c.schematically_equal(c_copy));
     }
+    {
+        // NOT(2) must not be merged with CNOT(2; 3) through CNOT(4; 2)
+        Circuit c("Lines: 6\nNOT(2)\nCNOT(1; 3)\nCNOT(4; 2)\nCNOT(4; 0)\nCNOT(2; 3)");
+        Circuit c_copy(c);
+        c.reduce();
+
+        EXPECT_EQ(c, c_copy);
+        EXPECT_EQ(c.produce_mapping(), c_copy.produce_mapping());
+    }
 }
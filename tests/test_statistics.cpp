@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+
+#include "statistics.hpp"
+#include "test_utils.hpp"
+
+TEST(Statistics, Running) {
+    const std::vector<double> values = {4, 8, 15, 16, 23, 42};
+    RunningStatistics all;
+    RunningStatistics left;
+    RunningStatistics right;
+    for (size_t i = 0; i < values.size(); i++) {
+        all.add(values[i]);
+        (i < 2 ? left : right).add(values[i]);
+    }
+    EXPECT_EQ(all.count(), 6);
+    EXPECT_DOUBLE_EQ(all.mean(), 18);
+    EXPECT_DOUBLE_EQ(all.variance(), 910.0 / 6);
+    EXPECT_DOUBLE_EQ(all.min(), 4);
+    EXPECT_DOUBLE_EQ(all.max(), 42);
+
+    left.merge(right);
+    EXPECT_EQ(left.count(), all.count());
+    EXPECT_DOUBLE_EQ(left.mean(), all.mean());
+    EXPECT_DOUBLE_EQ(left.variance(), all.variance());
+    EXPECT_DOUBLE_EQ(left.min(), all.min());
+    EXPECT_DOUBLE_EQ(left.max(), all.max());
+
+    RunningStatistics empty;
+    empty.merge(all);
+    EXPECT_DOUBLE_EQ(empty.mean(), all.mean());
+}
+
+TEST(Statistics, Exhaustive) {
+    {
+        ScopedJobs jobs(4);
+        auto statistics = exhaustive_statistics(Algo::OPT, 2);
+        EXPECT_EQ(statistics.processed(), 24);
+        EXPECT_EQ(statistics.failed(), 0);
+        EXPECT_DOUBLE_EQ(statistics.lines().mean(), 2);
+        EXPECT_DOUBLE_EQ(statistics.gates().min(), 0);
+        size_t histogram_sum = 0;
+        for (const auto &[gates, count]: statistics.gates_histogram()) {
+            histogram_sum += count;
+        }
+        EXPECT_EQ(histogram_sum, 24);
+
+        // 40320 substitutions split into chunks, the identity is the only one without gates
+        auto three_lines = exhaustive_statistics(Algo::OPT, 3);
+        EXPECT_EQ(three_lines.processed(), 40320);
+        EXPECT_EQ(three_lines.failed(), 0);
+        EXPECT_EQ(three_lines.gates_histogram().at(0), 1);
+    }
+
+    EXPECT_THROW(exhaustive_statistics(Algo::ZKB, 4), SynthException);
+    EXPECT_THROW(exhaustive_statistics(Algo::ZKB, 5), SynthException);
+}
+
+TEST(Statistics, Sampled) {
+    auto sampled = [](size_t jobs) {
+        ScopedJobs scoped_jobs(jobs);
+        return sampled_statistics(Algo::ZKB, 4, 1000, 42);
+    };
+    auto sequential = sampled(1);
+    auto parallel = sampled(4);
+
+    EXPECT_EQ(sequential.processed(), 1000);
+    EXPECT_EQ(sequential.gates_histogram(), parallel.gates_histogram());
+    EXPECT_DOUBLE_EQ(sequential.gates().min(), parallel.gates().min());
+    EXPECT_DOUBLE_EQ(sequential.gates().max(), parallel.gates().max());
+    EXPECT_NEAR(sequential.gates().mean(), parallel.gates().mean(), 1e-9);
+}
+
+TEST(Statistics, Checkpoint) {
+    auto path = (std::filesystem::temp_directory_path() / "qcs_statistics_checkpoint.txt").string();
+    std::filesystem::remove(path);
+
+    auto statistics = sampled_statistics(Algo::ZKB, 3, 700, 7, false, path);
+    ASSERT_TRUE(std::filesystem::exists(path));
+
+    // the finished run is read back from the checkpoint
+    auto resumed = sampled_statistics(Algo::ZKB, 3, 700, 7, false, path);
+    EXPECT_EQ(resumed.processed(), statistics.processed());
+    EXPECT_EQ(resumed.gates_histogram(), statistics.gates_histogram());
+    EXPECT_DOUBLE_EQ(resumed.gates().mean(), statistics.gates().mean());
+    EXPECT_DOUBLE_EQ(resumed.microseconds().mean(), statistics.microseconds().mean());
+
+    EXPECT_THROW(sampled_statistics(Algo::ZKB, 3, 700, 8, false, path), IOException);
+    std::filesystem::remove(path);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
+#include "jobs.hpp"
 #include "primitives.hpp"
+#include "test_utils.hpp"
 
 
 TEST(Substitutions, Constructor) {
@@ -254,6 +256,89 @@ TEST(Substitutions, Operations) {
     EXPECT_EQ(cayley_distance(Substitution("9 A 1 4 5 7 2 3 0 6 8"), Substitution("1 0")), 8);
 }
 
+TEST(Substitutions, Packed) {
+    std::mt19937_64 generator(11);
+    // a byte, two and four bytes per point
+    for (size_t power: {2, 16, 17, 256, 257, 65536, 65537}) {
+        auto images = random_images(power, generator);
+        auto sorted = images;
+        std::sort(sorted.begin(), sorted.end());
+        EXPECT_TRUE(Substitution(sorted).is_identical());
+        Substitution sub(images);
+        EXPECT_EQ(sub.vector(), images);
+        EXPECT_EQ(sub.power(), power);
+        EXPECT_EQ(sub.image(power - 1), images.back());
+        EXPECT_TRUE((sub * sub.invert()).is_identical());
+        EXPECT_EQ(Substitution(sub.vector()), sub);
+
+        auto composed = sub;
+        composed *= sub;
+        for (size_t x = 0; x < power; x += power / 16 + 1) {
+            EXPECT_EQ(composed.image(x), images[images[x]]);
+        }
+        EXPECT_EQ(std::hash<Substitution>()(Substitution(images)), std::hash<Substitution>()(sub));
+    }
+    for (size_t power = 2; power <= 20; power++) {
+        std::vector<size_t> images(power);
+        std::iota(images.begin(), images.end(), 0);
+        std::swap(images[power - 2], images.back());
+        EXPECT_FALSE(Substitution(images).is_identical());
+    }
+
+    // every substitution of 8 points is a different key
+    std::unordered_set<Substitution> keys;
+    std::unordered_set<size_t> hashes;
+    for (size_t rank = 0; rank < factorial(8); rank++) {
+        auto sub = substitution_by_rank(rank, 8);
+        keys.insert(sub);
+        hashes.insert(std::hash<Substitution>()(sub));
+    }
+    EXPECT_EQ(keys.size(), factorial(8));
+    EXPECT_EQ(hashes.size(), factorial(8));
+    EXPECT_TRUE(keys.count(Substitution("7 6 5 4 3 2 1 0")));
+    EXPECT_FALSE(keys.count(Substitution("8 7 6 5 4 3 2 1 0")));
+}
+
+TEST(Substitutions, Kernels) {
+    std::mt19937_64 generator(13);
+    ScopedJobs jobs(4);
+    for (size_t power: {4, 16, 32, 256, 4096, 65536, 131072}) {
+        auto images1 = random_images(power, generator);
+        auto images2 = random_images(power, generator);
+        Substitution sub1(images1);
+        Substitution sub2(images2);
+
+        auto composed = sub1 * sub2;
+        auto inverse = sub1.invert();
+        for (size_t x = 0; x < power; x++) {
+            ASSERT_EQ(composed.image(x), images2[images1[x]]);
+            ASSERT_EQ(inverse.image(images1[x]), x);
+        }
+        auto inverted = sub1;
+        EXPECT_EQ(inverted.invert_in_place(), inverse);
+        EXPECT_EQ(inverted.invert_in_place(), sub1);
+
+        // the distance by the cycles of h^-1 * g
+        EXPECT_EQ(cayley_distance(sub1, sub2), power - (sub2.invert() * sub1).cycles().size());
+        EXPECT_EQ(cayley_distance(sub1, sub1), 0);
+        EXPECT_EQ(sub1.cycles_number(), sub1.cycles().size());
+    }
+}
+
+TEST(Substitutions, Rank) {
+    EXPECT_EQ(substitution_rank(Substitution("0 1 2 3 4 5 6 7")), 0);
+    EXPECT_EQ(substitution_rank(Substitution("7 6 5 4 3 2 1 0")), 40319);
+    EXPECT_EQ(substitution_by_rank(0, 8), Substitution(8));
+    EXPECT_EQ(substitution_by_rank(40319, 8), Substitution("7 6 5 4 3 2 1 0"));
+
+    Substitution s("3 B 2 A 0 7 1 6 F 8 E 9 D 5 C 4");
+    EXPECT_EQ(substitution_by_rank(substitution_rank(s), s.power()), s);
+
+    EXPECT_THROW(substitution_by_rank(0, 1), SubException);
+    EXPECT_THROW(substitution_by_rank(24, 4), SubException);
+    EXPECT_THROW(substitution_rank(Substitution(21)), SubException);
+}
+
 TEST(Substitutions, Stream) {
     auto s = Substitution("0x0 2 0X3 0x4 0X5 0x1 0x7 0x6 0x8 0x9 C 0xb 0xA");
     std::stringstream out_stream;
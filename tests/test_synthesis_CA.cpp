@@ -184,3 +184,44 @@ TEST(Synthesis, SubstitutionCA) {
 //        EXPECT_EQ(c.produce_mapping(), sub);
     }
 }
+
+TEST(Synthesis, CacheCA) {
+    JobsConfig::instance().set(std::thread::hardware_concurrency());
+    CA_cache().clear();
+
+    // rotations of a cycle share one cache entry
+    Circuit c = CA_cycle_synthesis({3, 9, 12, 5});
+    EXPECT_EQ(CA_cache().size(), 1);
+    EXPECT_EQ(CA_cycle_synthesis({12, 5, 3, 9}), c);
+    EXPECT_EQ(CA_cache().size(), 1);
+    EXPECT_EQ(c.produce_mapping(), substitution_power_of_2_by_cycle({3, 9, 12, 5}));
+
+    EXPECT_EQ(CA_cycle_synthesis({3, 5, 12, 9}).produce_mapping(), substitution_power_of_2_by_cycle({3, 5, 12, 9}));
+    EXPECT_EQ(CA_cache().size(), 2);
+
+    Substitution sub("1 10 5 7 14 3 13 6 0 9 11 4 15 8 12 2");
+    Circuit cached = CA_algorithm(sub);
+    CA_cache().clear();
+    EXPECT_EQ(CA_algorithm(sub), cached);
+}
+
+TEST(Synthesis, ParallelCA) {
+    {
+        Substitution sub("0 1 2 3 4 5 6 7");
+        JobsConfig::instance().set(4);
+        EXPECT_EQ(CA_algorithm(sub).produce_mapping(), sub);
+    }
+    for (const auto &sub: {Substitution("5 3 0 1 7 6 2 4"),
+                           Substitution("1 10 5 7 14 3 13 6 0 9 11 4 15 8 12 2"),
+                           Substitution("21 27 23 8 6 11 5 18 22 26 7 13 12 28 20 4 1 2 9 14 16 17 15 24 19 10 25 "
+                                        "31 0 3 30 29")}) {
+        JobsConfig::instance().set(1);
+        Circuit c = CA_algorithm(sub);
+        for (size_t threads: {2, 3, 8}) {
+            CA_cache().clear();
+            JobsConfig::instance().set(threads);
+            EXPECT_EQ(CA_algorithm(sub), c);
+        }
+    }
+    JobsConfig::instance().set(std::thread::hardware_concurrency());
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "synthesis.hpp"
+#include "test_utils.hpp"
 
 
 TEST(Synthesis, MappingSS) {
@@ -144,3 +145,29 @@ TEST(Synthesis, SubstitutionSS) {
         EXPECT_THROW(GS_algorithm(sub), SynthException);
     }
 }
+
+TEST(Synthesis, BeamGS) {
+    std::mt19937_64 generator(13);
+    {
+        ScopedJobs jobs(4);
+        for (size_t dim = 3; dim <= 4; dim++) {
+            for (size_t i = 0; i < 10; i++) {
+                auto sub = random_substitution(dim, generator);
+                // greedy GS fails on most of these
+                auto c = GS_beam_algorithm(sub);
+                EXPECT_EQ(Substitution(c.produce_mapping()), sub);
+                EXPECT_EQ(synthesize(sub, Algo::GS_BEAM), c);
+                EXPECT_LE(GS_beam_algorithm(sub, GS_BEAM_WIDTH, true).complexity(), c.complexity());
+            }
+        }
+    }
+
+    EXPECT_EQ(GS_beam_algorithm(Substitution(8)).complexity(), 0);
+    EXPECT_THROW(GS_beam_algorithm(Substitution(8), 0), SynthException);
+    EXPECT_THROW(BeamConfig::instance().set(0), SynthException);
+
+    BinaryMapping bm(table{{0, 1, 1, 0, 1, 1, 1, 1}});
+    auto c = GS_beam_algorithm(bm, 4);
+    EXPECT_EQ(c.memory(), 1);
+    EXPECT_EQ(c.produce_mapping().coordinate_functions().back(), BooleanFunction("01101111"));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include "database.hpp"
+#include "test_utils.hpp"
+
+
+TEST(Synthesis, PackedSubstitutions) {
+    std::mt19937_64 generator(17);
+    auto sub = random_substitution(4, generator);
+    EXPECT_EQ(unpack_substitution(pack_substitution(sub), 16), sub);
+    EXPECT_EQ(pack_substitution(Substitution(std::vector<size_t>{1, 0})), 1);
+    EXPECT_THROW(pack_substitution(Substitution(32)), SynthException);
+
+    PackedSubstitutionTable hash_table(4);
+    for (uint64_t key = 0; key < 1000; key++) {
+        EXPECT_TRUE(hash_table.insert(key * 0x10001, static_cast<uint8_t>(key % 7)));
+    }
+    EXPECT_FALSE(hash_table.insert(0x10001, 0));
+    EXPECT_EQ(hash_table.size(), 1000);
+    for (uint64_t key = 0; key < 1000; key++) {
+        const auto *gate = hash_table.find(key * 0x10001);
+        ASSERT_NE(gate, nullptr);
+        EXPECT_EQ(*gate, key % 7);
+    }
+    EXPECT_EQ(hash_table.find(3), nullptr);
+}
+
+TEST(Synthesis, MappingMITM) {
+    std::mt19937_64 generator(19);
+    {
+        ScopedJobs jobs(4);
+        // the circuits are as short as the optimal ones
+        for (size_t dim = 1; dim <= OPT_MAX_DIM; dim++) {
+            for (size_t i = 0; i < 10; i++) {
+                auto sub = random_substitution(dim, generator);
+                auto c = MITM_algorithm(sub);
+                EXPECT_EQ(Substitution(c.produce_mapping()), sub);
+                EXPECT_EQ(c.complexity(), OPT_algorithm(sub).complexity());
+            }
+        }
+
+        // no circuit longer than the one the substitution was built by
+        const auto gates = generate_all_gates(4);
+        for (size_t length = 1; length <= 6; length++) {
+            Circuit built(4);
+            for (size_t i = 0; i < length; i++) {
+                built.add(gates[generator() % gates.size()]);
+            }
+            Substitution sub(built.produce_mapping());
+            auto c = synthesize(sub, Algo::MITM);
+            EXPECT_EQ(Substitution(c.produce_mapping()), sub);
+            EXPECT_LE(c.complexity(), built.complexity());
+            EXPECT_EQ(MITM_algorithm(sub), c);
+        }
+    }
+
+    EXPECT_EQ(MITM_algorithm(Substitution(16)).complexity(), 0);
+    EXPECT_THROW(MITM_algorithm(Substitution(32)), SynthException);
+
+    BinaryMapping bm(table{{0, 1, 1, 0, 1, 1, 1, 1}});
+    auto c = MITM_algorithm(bm);
+    EXPECT_EQ(c.memory(), 1);
+    EXPECT_EQ(c.produce_mapping().coordinate_functions().back(), BooleanFunction("01101111"));
+
+    ScopedMemoryBudget memory_budget(1 << 16);
+    EXPECT_THROW(MITM_algorithm(random_substitution(4, generator)), SynthException);
+}
+
+TEST(Synthesis, RandomMITM) {
+    // a random 4-line substitution at the default memory budget, its optimal circuits are 7 gates long
+    std::mt19937_64 generator(8);
+    auto sub = random_substitution(4, generator);
+    auto c = MITM_algorithm(sub);
+    EXPECT_EQ(Substitution(c.produce_mapping()), sub);
+    EXPECT_EQ(c.complexity(), 7);
+    auto reduced = c;
+    reduced.reduce();
+    EXPECT_EQ(reduced.complexity(), c.complexity());
+}
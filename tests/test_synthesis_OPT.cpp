@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include "database.hpp"
+
+
+TEST(Synthesis, MappingOPT) {
+    JobsConfig::instance().set(std::thread::hardware_concurrency());
+
+    {
+        BinaryMapping bm(table{{1, 0}});
+        Circuit c = OPT_algorithm(bm);
+        EXPECT_EQ(synthesize(bm, Algo::OPT), c);
+        EXPECT_EQ(synthesize(bm, Algo::OPT, true), c);
+        EXPECT_EQ(c.produce_mapping().coordinate_functions().front(), BooleanFunction("10"));
+        EXPECT_EQ(c.complexity(), 1);
+        EXPECT_EQ(c.memory(), 0);
+    }
+    {
+        BinaryMapping bm(table{{0, 1, 1, 1}});
+        Circuit c = OPT_algorithm(bm);
+        EXPECT_EQ(synthesize(bm, Algo::OPT), c);
+        EXPECT_EQ(synthesize(bm, Algo::OPT, true), c);
+        EXPECT_EQ(c.produce_mapping().coordinate_functions().back(), BooleanFunction("0111"));
+        EXPECT_EQ(c.memory(), 1);
+    }
+    {
+        BinaryMapping bm(table{{0, 0, 0, 0, 1, 1, 1, 1},
+                               {0, 0, 1, 1, 0, 0, 1, 1},
+                               {0, 1, 0, 1, 0, 1, 0, 1}});
+        Circuit c = OPT_algorithm(bm);
+        EXPECT_EQ(c.produce_mapping(), bm);
+        EXPECT_EQ(c.complexity(), 0);
+    }
+    {
+        BinaryMapping bm(table{{0, 1, 1, 0, 1, 1, 1, 1}});
+        EXPECT_THROW(OPT_algorithm(bm), SynthException);
+    }
+    {
+        BinaryMapping bm(table{{0, 0, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 1, 1},
+                               {0, 1, 1, 0, 1, 0, 1, 0, 0, 1, 1, 0, 1, 1, 0, 0},
+                               {1, 1, 0, 0, 1, 1, 1, 1, 0, 0, 0, 0, 1, 0, 0, 1},
+                               {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0}});
+        EXPECT_THROW(OPT_algorithm(bm), SynthException);
+    }
+}
+
+TEST(Synthesis, SubstitutionOPT) {
+    JobsConfig::instance().set(std::thread::hardware_concurrency());
+
+    EXPECT_THROW(OPT_algorithm(Substitution("0 2 1")), SynthException);
+    EXPECT_THROW(OPT_algorithm(Substitution(16)), SynthException);
+
+    for (size_t rank = 0; rank < factorial(4); rank++) {
+        auto sub = substitution_by_rank(rank, 4);
+        Circuit c = OPT_algorithm(sub);
+        EXPECT_EQ(synthesize(sub, Algo::OPT), c);
+        EXPECT_EQ(c.produce_mapping(), sub);
+        EXPECT_EQ(c.complexity() == 0, sub.is_identical());
+    }
+
+    for (size_t rank = 0; rank < factorial(8); rank += 97) {
+        auto sub = substitution_by_rank(rank, 8);
+        Circuit c = OPT_algorithm(sub);
+        EXPECT_EQ(c.produce_mapping(), sub);
+        EXPECT_LE(OPT_algorithm(sub, true).complexity(), c.complexity());
+        try {
+            EXPECT_LE(c.complexity(), GS_algorithm(sub).complexity());
+        } catch (const SynthException &) {
+        }
+    }
+
+    // each gate is a circuit of complexity 1
+    for (const auto &gate: generate_all_gates(3)) {
+        EXPECT_EQ(OPT_algorithm(gate.act()).complexity(), 1);
+    }
+}
+
+TEST(Synthesis, DatabaseOPT) {
+    JobsConfig::instance().set(std::thread::hardware_concurrency());
+
+    auto &database = OptimalDatabase::instance();
+    EXPECT_THROW(database.build(0), SynthException);
+    EXPECT_THROW(database.build(OPT_MAX_DIM + 1), SynthException);
+
+    database.build(2);
+    database.build(3);
+    EXPECT_TRUE(database.contains(2));
+    EXPECT_TRUE(database.contains(3));
+    EXPECT_FALSE(database.contains(OPT_MAX_DIM + 1));
+
+    Substitution sub("3 6 7 5 0 2 4 1");
+    auto c = database.circuit(sub);
+
+    const std::string path = "optimal_database.bin";
+    database.save(path);
+    database.clear();
+    EXPECT_FALSE(database.contains(3));
+    database.load(path);
+    EXPECT_TRUE(database.contains(2));
+    EXPECT_TRUE(database.contains(3));
+    EXPECT_TRUE(database.circuit(sub).schematically_equal(c));
+
+    // readers keep their tables while the database is replaced
+    std::atomic<size_t> mismatches = 0;
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < 2; i++) {
+        readers.emplace_back([&]() {
+            for (size_t j = 0; j < 200; j++) {
+                mismatches += !database.circuit(sub).schematically_equal(c);
+            }
+        });
+    }
+    for (size_t i = 0; i < 20; i++) {
+        database.clear();
+        database.load(path);
+    }
+    for (auto &reader: readers) {
+        reader.join();
+    }
+    EXPECT_EQ(mismatches, 0);
+    std::remove(path.c_str());
+
+    EXPECT_THROW(database.load("../tests/assets/sub.txt"), IOException);
+    EXPECT_THROW(database.load("missing_database.bin"), IOException);
+}
@@ -140,3 +140,24 @@ TEST(Synthesis, SubstitutionDummy) {
         EXPECT_EQ(synthesize(sub, Algo::DUMMY, true), c);
     }
 }
+
+TEST(Synthesis, ParallelDummy) {
+    // one dense output and several sparse ones
+    BinaryMapping bm(table{{0, 1, 1, 0, 1, 0, 0, 1, 0, 0, 0, 1, 1, 1, 0, 1},
+                           {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1},
+                           {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1},
+                           {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+                           {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1}});
+    JobsConfig::instance().set(1);
+    Circuit c = dummy_algorithm(bm);
+    EXPECT_EQ(c.memory(), 5);
+    // the outputs scheduled by weight still land on their own lines
+    for (size_t x = 0; x < 16; x++) {
+        EXPECT_EQ(c.act(uint64_t(x << 5)) & 31, bm.row(x));
+    }
+    for (size_t threads: {2, 3, 8}) {
+        JobsConfig::instance().set(threads);
+        EXPECT_EQ(dummy_algorithm(bm), c);
+    }
+    JobsConfig::instance().set(std::thread::hardware_concurrency());
+}
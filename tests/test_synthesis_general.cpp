@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <format>
+#include <random>
 
 #include "synthesis.hpp"
 
@@ -18,6 +19,127 @@ TEST(Synthesis, General) {
     EXPECT_NO_THROW(synthesize(bm));
 }
 
+TEST(Synthesis, MinimalGarbage) {
+    BinaryMapping bm(table{{1, 1, 0, 1, 0, 0, 1, 0},
+                           {0, 1, 1, 1, 1, 0, 0, 0}});
+    for (auto algo: {Algo::RW, Algo::ZKB, Algo::OPT}) {
+        auto c = synthesize(bm, algo, false, Embedding::MINIMAL_GARBAGE);
+        EXPECT_EQ(c.dim(), 3);
+        EXPECT_EQ(c.memory(), 0);
+        for (size_t x = 0; x < 8; x++) {
+            EXPECT_EQ(c.act(uint64_t(x)) & 3, bm.row(x));
+        }
+    }
+    EXPECT_EQ(synthesize(bm, Algo::ZKB, false, Embedding::BENNETT).dim(), 5);
+    EXPECT_EQ(synthesize(bm, Algo::DUMMY, false, Embedding::MINIMAL_GARBAGE).dim(), 5);
+
+    // a constant output needs garbage lines for all the inputs
+    BinaryMapping constant(table{{1, 1, 1, 1}});
+    auto c = synthesize(constant, Algo::ZKB, false, Embedding::MINIMAL_GARBAGE);
+    EXPECT_EQ(c.dim(), 3);
+    EXPECT_EQ(c.memory(), 1);
+    for (size_t x = 0; x < 4; x++) {
+        EXPECT_EQ(c.act(uint64_t(x << 1)) & 1, 1);
+    }
+}
+
+TEST(Synthesis, Deadline) {
+    std::mt19937_64 generator(11);
+    std::vector<size_t> images(256);
+    std::iota(images.begin(), images.end(), 0);
+    std::shuffle(images.begin(), images.end(), generator);
+    Substitution sub(images);
+
+    StopCondition expired;
+    expired.set_deadline(synthesis_clock::now());
+    for (auto algo: {Algo::RW, Algo::GS, Algo::GS_BEAM, Algo::CA}) {
+        try {
+            synthesize(sub, algo, false, expired);
+            ADD_FAILURE() << "the synthesis should have been timed out";
+        } catch (const TimeoutException &e) {
+            ASSERT_TRUE(e.partial());
+            EXPECT_EQ(e.partial()->dim(), 8);
+        }
+    }
+    try {
+        synthesize(sub, Algo::ZKB, false, expired);
+        ADD_FAILURE() << "the synthesis should have been timed out";
+    } catch (const TimeoutException &e) {
+        EXPECT_FALSE(e.partial());
+    }
+    EXPECT_THROW(synthesize(BinaryMapping(sub), Algo::DUMMY, false, expired), TimeoutException);
+
+    // GS stops between its greedy steps, the partial circuit holds the steps made
+    StopCondition limited;
+    limited.set_timeout(std::chrono::milliseconds(50));
+    auto start = synthesis_clock::now();
+    try {
+        synthesize(sub, Algo::GS, false, limited);
+    } catch (const TimeoutException &e) {
+        ASSERT_TRUE(e.partial());
+        EXPECT_LT(synthesis_clock::now() - start, std::chrono::seconds(5));
+    }
+
+    // a cancelled condition is not a timeout, a child condition stops with its parent
+    StopCondition parent;
+    StopCondition child(&parent);
+    parent.request_stop();
+    EXPECT_EQ(child.reason(), StopReason::REQUESTED);
+    try {
+        synthesize(sub, Algo::ZKB, false, child);
+        ADD_FAILURE() << "the synthesis should have been cancelled";
+    } catch (const TimeoutException &) {
+        ADD_FAILURE() << "the synthesis should not have been timed out";
+    } catch (const CancelledException &) {
+    }
+    EXPECT_NO_THROW(synthesize(sub, Algo::ZKB, false, StopCondition()));
+}
+
+TEST(Synthesis, Verification) {
+    const size_t dim = 14;
+    Circuit c(dim);
+    c.add(Gate("kCNOT(0; 3, !5, 13)", dim));
+    c.add(Gate("CSWAP(2, 7; 1)", dim));
+    c.add(Gate("NOT(13)", dim));
+    Substitution sub(c.produce_mapping());
+    auto images = sub.vector();
+    std::swap(images[1], images[2]);
+    Substitution wrong_point(images);
+    Circuit wrong_everywhere = c;
+    wrong_everywhere.add(Gate("NOT(0)", dim));
+
+    VerificationConfig::instance().set(Verification::FULL);
+    EXPECT_TRUE(verify(c, sub));
+    EXPECT_FALSE(verify(c, wrong_point));
+    EXPECT_FALSE(verify(wrong_everywhere, sub));
+    EXPECT_FALSE(verify(c, Substitution(8)));
+
+    VerificationConfig::instance().set(Verification::SAMPLED);
+    EXPECT_TRUE(verify(c, sub));
+    EXPECT_TRUE(verify(c, BinaryMapping(sub)));
+    EXPECT_FALSE(verify(wrong_everywhere, sub));
+    EXPECT_FALSE(verify(wrong_everywhere, BinaryMapping(sub)));
+    EXPECT_NO_THROW(ZKB_algorithm(sub));
+
+    // inputs of a circuit with memory are the upper lines
+    Circuit memory_circuit("Lines: 5; 2\nCNOT(4; 0)\nkCNOT(3; 1, !2)\nSWAP(0, 4)");
+    auto bm = memory_circuit.produce_mapping();
+    VerificationConfig::instance().set_samples(4);
+    EXPECT_TRUE(verify(memory_circuit, bm));
+    VerificationConfig::instance().set(Verification::FULL);
+    EXPECT_TRUE(verify(memory_circuit, bm));
+
+    VerificationConfig::instance().set(Verification::NONE);
+    EXPECT_TRUE(verify(wrong_everywhere, sub));
+
+    VerificationConfig::instance().set_confidence(0.99, 0.01);
+    EXPECT_EQ(VerificationConfig::instance().samples(), 459);
+    EXPECT_THROW(VerificationConfig::instance().set_confidence(1, 0.01), SynthException);
+
+    VerificationConfig::instance().set(Verification::FULL);
+    VerificationConfig::instance().set_samples(VERIFICATION_SAMPLES);
+}
+
 template<typename T>
 bool contains(const std::vector<T> &vec, const T &value) {
     return std::find(vec.begin(), vec.end(), value) != vec.end();
@@ -0,0 +1,104 @@
+#ifndef QUANTUM_CIRCUIT_SYNTHESIS_TEST_UTILS_HPP
+#define QUANTUM_CIRCUIT_SYNTHESIS_TEST_UTILS_HPP
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#include "autotune.hpp"
+#include "mitm.hpp"
+#include "portfolio.hpp"
+
+// the images of a uniformly random substitution of the power
+inline std::vector<size_t> random_images(size_t power, std::mt19937_64 &generator) {
+    std::vector<size_t> images(power);
+    std::iota(images.begin(), images.end(), 0);
+    std::shuffle(images.begin(), images.end(), generator);
+    return images;
+}
+
+// a uniformly random substitution of 2^dim points
+inline Substitution random_substitution(size_t dim, std::mt19937_64 &generator) {
+    return Substitution(random_images(size_t(1) << dim, generator));
+}
+
+// the scoped restores bring a global configuration back when a test leaves the scope, also after a failed assertion
+
+class ScopedJobs {
+public:
+    explicit ScopedJobs(size_t jobs) : saved_(JobsConfig::instance().get()) {
+        JobsConfig::instance().set(jobs);
+    }
+
+    ~ScopedJobs() {
+        JobsConfig::instance().set(saved_);
+    }
+
+    ScopedJobs(const ScopedJobs &) = delete;
+
+    ScopedJobs &operator=(const ScopedJobs &) = delete;
+
+private:
+    size_t saved_;
+};
+
+class ScopedPortfolioConfig {
+public:
+    ScopedPortfolioConfig() : algorithms_(PortfolioConfig::instance().algorithms()),
+                              timeout_(PortfolioConfig::instance().timeout()),
+                              metric_(PortfolioConfig::instance().metric()) {}
+
+    ~ScopedPortfolioConfig() {
+        PortfolioConfig::instance().set_algorithms(algorithms_);
+        PortfolioConfig::instance().set_timeout(timeout_);
+        PortfolioConfig::instance().set_metric(metric_);
+    }
+
+    ScopedPortfolioConfig(const ScopedPortfolioConfig &) = delete;
+
+    ScopedPortfolioConfig &operator=(const ScopedPortfolioConfig &) = delete;
+
+private:
+    std::vector<Algo> algorithms_;
+    std::chrono::milliseconds timeout_;
+    circuit_metric metric_;
+};
+
+class ScopedMemoryBudget {
+public:
+    explicit ScopedMemoryBudget(size_t bytes) : saved_(MITMConfig::instance().memory_budget()) {
+        MITMConfig::instance().set_memory_budget(bytes);
+    }
+
+    ~ScopedMemoryBudget() {
+        MITMConfig::instance().set_memory_budget(saved_);
+    }
+
+    ScopedMemoryBudget(const ScopedMemoryBudget &) = delete;
+
+    ScopedMemoryBudget &operator=(const ScopedMemoryBudget &) = delete;
+
+private:
+    size_t saved_;
+};
+
+class ScopedCostModel {
+public:
+    ScopedCostModel() {
+        CostModel::instance().save(saved_);
+    }
+
+    ~ScopedCostModel() {
+        CostModel::instance().load(saved_);
+    }
+
+    ScopedCostModel(const ScopedCostModel &) = delete;
+
+    ScopedCostModel &operator=(const ScopedCostModel &) = delete;
+
+private:
+    std::stringstream saved_;
+};
+
+#endif //QUANTUM_CIRCUIT_SYNTHESIS_TEST_UTILS_HPP